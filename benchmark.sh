@@ -0,0 +1,156 @@
+#!/usr/bin/env bash
+# Varredura de desempenho das ordenações de DNA e de inteiros, com saída em CSV.
+#
+# Parâmetros por variável de ambiente (listas separadas por espaço):
+#   ALGORITMOS  DNA: qsort radix (sequenciais), odd_even, amostra histograma
+#               (sample sort com cada escolha de separadores)
+#               inteiros: inteiros_amostra inteiros_histograma (sample sort
+#               de for_numbers), baldes (bucket sort distribuído)
+#   NS          números de sequências (DNA) e de elementos (inteiros)
+#   TAMANHOS    comprimentos das sequências (1 a 60)
+#   PROCESSOS   números de processos MPI (ignorado nos sequenciais)
+#   REPETICOES  execuções por configuração
+#   SAIDA       arquivo CSV (sobrescrito)
+#   MPIRUN      comando do lançador MPI, com as opções dele
+#   FORMATO     texto ou binario: formato da entrada gerada (os ordenadores
+#               reconhecem o binário pelo cabeçalho)
+#
+# Exemplo:
+#   NS="100000 1000000" PROCESSOS="2 4 8" REPETICOES=3 ./benchmark.sh
+#
+# Cada configuração vira uma linha com a mediana e a variância do tempo de
+# parede da ordenação (leitura e escrita ficam de fora), a vazão em
+# chaves/s e o speedup em relação à mediana do qsort sequencial com o mesmo
+# n e comprimento (vazio se o qsort não estiver em ALGORITMOS). A entrada é
+# gerada com semente fixa, então as execuções são comparáveis entre si; o
+# odd_even gera as próprias sequências (semente fixa por processo).
+# Os inteiros são gerados pelos próprios programas (uniformes em
+# [0, MAIOR_INTEIRO)) e varridos só por n: o comprimento e o speedup ficam
+# vazios nessas linhas.
+
+set -euo pipefail
+
+ALGORITMOS=${ALGORITMOS:-"qsort radix odd_even amostra histograma inteiros_amostra inteiros_histograma baldes"}
+NS=${NS:-"100000"}
+TAMANHOS=${TAMANHOS:-"50"}
+PROCESSOS=${PROCESSOS:-"2 4"}
+REPETICOES=${REPETICOES:-5}
+SAIDA=${SAIDA:-resultados.csv}
+MPIRUN=${MPIRUN:-mpirun}
+FORMATO=${FORMATO:-texto}
+MAIOR_INTEIRO=${MAIOR_INTEIRO:-1000000000}
+SEMENTE=42
+
+RAIZ=$(cd "$(dirname "$0")" && pwd)
+SAIDA=$(realpath -m "$SAIDA")
+TRABALHO=$(mktemp -d)
+trap 'rm -rf "$TRABALHO"' EXIT
+
+# compila tudo com otimização num diretório temporário
+gcc -O2 -fopenmp -o "$TRABALHO/generate_sequence" "$RAIZ/generate_sequence.c"
+gcc -O2 -o "$TRABALHO/sequencial_qsort" "$RAIZ/for_DNAsequences/sequencial_qsort.c"
+mpicc -O2 -o "$TRABALHO/odd_even_paralelo" "$RAIZ/odd_even_paralelo.c"
+mpicc -O2 -o "$TRABALHO/parallel_split_sort" "$RAIZ/for_DNAsequences/parallel_split_sort.c"
+mpicc -O2 -fopenmp -o "$TRABALHO/int_split_sort" "$RAIZ/for_numbers/parallel_split_sort.c"
+mpicc -O2 -fopenmp -o "$TRABALHO/int_bucket_sort" "$RAIZ/for_numbers/parallel_bucket_sort.c"
+
+# tempo de uma execução: segundo número da linha "Tempo ...: X segundos"
+# (qsort: "Tempo gasto para ordenar"; MPI: "Tempo de execucao")
+executa() {
+    local algoritmo=$1 n=$2 tamanho=$3 procs=$4 entrada=$5
+    case $algoritmo in
+        qsort|radix)
+            "$TRABALHO/sequencial_qsort" -m "$algoritmo" "$entrada" "$TRABALHO/saida.txt" |
+                awk '/Tempo gasto para ordenar/ { print $(NF - 1) }'
+            ;;
+        odd_even)
+            $MPIRUN -np "$procs" "$TRABALHO/odd_even_paralelo" -q -e "$n" "$tamanho" |
+                awk '/Tempo de execucao: .* segundos/ { print $(NF - 1) }'
+            ;;
+        amostra|histograma)
+            $MPIRUN -np "$procs" "$TRABALHO/parallel_split_sort" -q -o mpiio -s "$algoritmo" \
+                "$entrada" | awk '/Tempo de execucao/ { print $(NF - 1) }'
+            ;;
+        inteiros_amostra|inteiros_histograma)
+            $MPIRUN -np "$procs" "$TRABALHO/int_split_sort" -q -n "$n" -m "$MAIOR_INTEIRO" \
+                -s "${algoritmo#inteiros_}" | awk '/Tempo de execucao/ { print $(NF - 1) }'
+            ;;
+        baldes)
+            $MPIRUN -np "$procs" "$TRABALHO/int_bucket_sort" -q -n "$n" -m "$MAIOR_INTEIRO" |
+                awk '/Tempo de execucao/ { print $(NF - 1) }'
+            ;;
+        *)
+            echo "algoritmo desconhecido: $algoritmo" >&2
+            exit 1
+            ;;
+    esac
+}
+
+# mediana e variância (amostral) de uma coluna de tempos
+estatisticas() {
+    sort -g | awk '
+        { t[NR] = $1; soma += $1 }
+        END {
+            if (NR == 0) exit 1
+            media = soma / NR
+            for (i = 1; i <= NR; i++) var += (t[i] - media) ^ 2
+            var = NR > 1 ? var / (NR - 1) : 0
+            mediana = NR % 2 ? t[(NR + 1) / 2] : (t[NR / 2] + t[NR / 2 + 1]) / 2
+            printf "%.6f %.9f\n", mediana, var
+        }'
+}
+
+# mede uma configuração (REPETICOES execuções) e acrescenta a linha do CSV;
+# base é a mediana do qsort para o speedup (vazia: sem speedup); a mediana
+# medida fica em $mediana
+mede() {
+    local algoritmo=$1 n=$2 tamanho=$3 procs=$4 entrada=$5 base=$6
+    local tempos="" variancia
+    for ((r = 0; r < REPETICOES; r++)); do
+        tempos+="$(executa "$algoritmo" "$n" "$tamanho" "$procs" "$entrada")"$'\n'
+    done
+    read -r mediana variancia < <(printf "%s" "$tempos" | estatisticas)
+    awk -v a="$algoritmo" -v n="$n" -v l="$tamanho" -v p="$procs" \
+        -v r="$REPETICOES" -v m="$mediana" -v v="$variancia" -v b="$base" '
+        BEGIN {
+            vazao = m > 0 ? sprintf("%.0f", n / m) : ""
+            speedup = b != "" && m > 0 ? sprintf("%.3f", b / m) : ""
+            printf "%s,%s,%s,%s,%s,%s,%s,%s,%s\n", a, n, l, p, r, m, v, vazao, speedup
+        }' | tee -a "$SAIDA"
+}
+
+echo "algoritmo,n,comprimento,processos,repeticoes,mediana_s,variancia_s2,chaves_por_s,speedup" >"$SAIDA"
+
+cd "$TRABALHO"
+mkdir -p input
+for n in $NS; do
+    for tamanho in $TAMANHOS; do
+        case $FORMATO in
+            binario) entrada="input/dna_${n}_${tamanho}.bin" ;;
+            *) entrada="input/dna_${n}_${tamanho}.txt" ;;
+        esac
+        ./generate_sequence -f "$FORMATO" "$n" "$entrada" "$tamanho" "$SEMENTE" >/dev/null
+        base=""
+        for algoritmo in $ALGORITMOS; do
+            case $algoritmo in
+                inteiros_*|baldes) continue ;;
+                qsort|radix) lista_procs=1 ;;
+                *) lista_procs=$PROCESSOS ;;
+            esac
+            for procs in $lista_procs; do
+                mede "$algoritmo" "$n" "$tamanho" "$procs" "$entrada" "$base"
+                [ "$algoritmo" = qsort ] && base=$mediana
+            done
+        done
+    done
+    # inteiros: uma configuração por n e número de processos
+    for algoritmo in $ALGORITMOS; do
+        case $algoritmo in
+            inteiros_*|baldes) ;;
+            *) continue ;;
+        esac
+        for procs in $PROCESSOS; do
+            mede "$algoritmo" "$n" "" "$procs" "" ""
+        done
+    done
+done
@@ -0,0 +1,211 @@
+// dna_convert.c: conversao entre o formato texto (uma sequencia por linha)
+// e o formato binario empacotado usado pelos ordenadores
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DNA_CHARS "ACGT"
+// 32 bases na palavra 0 + 28 na palavra 1; os 8 bits finais guardam o comprimento
+#define DNA_KEY_MAX_BASES 60
+// registros por leitura/escrita
+#define CONVERT_BLOCK 65536
+
+// sequencia empacotada com 2 bits por base (A=0, C=1, G=2, T=3)
+// a comparacao de (w[0], w[1]) como inteiros sem sinal equivale ao strcmp
+typedef struct {
+  uint64_t w[2];
+} dna_key;
+
+// Arquivo binario: cabecalho de 32 bytes e depois os registros, cada um um
+// dna_key de 16 bytes como fica na memoria (w[0], w[1], little-endian).
+// O registro i comeca em sizeof(dna_bin_header) + i * sizeof(dna_key)
+#define DNA_BIN_MAGIC "DNA2BIT"
+#define DNA_BIN_VERSION 1
+#define DNA_BIN_ENCODING_2BIT 1
+
+typedef struct {
+  char magic[8];        // "DNA2BIT\0"
+  uint32_t version;     // DNA_BIN_VERSION
+  uint32_t encoding;    // DNA_BIN_ENCODING_2BIT
+  uint64_t count;       // numero de registros
+  uint32_t seq_length;  // comprimento comum das sequencias, 0 se variar
+  uint32_t record_size; // sizeof(dna_key)
+} dna_bin_header;
+
+// codigo de 2 bits da base, ou -1 se nao for A/C/G/T
+static inline int dna_base_code(char c) {
+  switch (c) {
+  case 'A':
+    return 0;
+  case 'C':
+    return 1;
+  case 'G':
+    return 2;
+  case 'T':
+    return 3;
+  }
+  return -1;
+}
+
+// empacota os len primeiros caracteres; retorna 0 se nao couberem na chave
+int dna_pack_n(const char *seq, int len, dna_key *key) {
+  key->w[0] = key->w[1] = 0;
+  if (len > DNA_KEY_MAX_BASES)
+    return 0;
+  for (int i = 0; i < len; i++) {
+    int code = dna_base_code(seq[i]);
+    if (code < 0)
+      return 0;
+    key->w[i / 32] |= (uint64_t)code << (62 - 2 * (i % 32));
+  }
+  key->w[1] |= (uint64_t)len;
+  return 1;
+}
+
+// desempacota a chave para texto (seq precisa de DNA_KEY_MAX_BASES + 1)
+void dna_unpack(const dna_key *key, char *seq) {
+  int len = (int)(key->w[1] & 0xFF);
+  if (len > DNA_KEY_MAX_BASES)
+    len = DNA_KEY_MAX_BASES;
+  for (int i = 0; i < len; i++) {
+    seq[i] = DNA_CHARS[(key->w[i / 32] >> (62 - 2 * (i % 32))) & 3];
+  }
+  seq[len] = '\0';
+}
+
+void dna_bin_header_init(dna_bin_header *h, uint64_t count, uint32_t length) {
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, DNA_BIN_MAGIC, sizeof(DNA_BIN_MAGIC));
+  h->version = DNA_BIN_VERSION;
+  h->encoding = DNA_BIN_ENCODING_2BIT;
+  h->count = count;
+  h->seq_length = length;
+  h->record_size = sizeof(dna_key);
+}
+
+int dna_bin_header_valid(const dna_bin_header *h) {
+  return memcmp(h->magic, DNA_BIN_MAGIC, sizeof(DNA_BIN_MAGIC)) == 0 &&
+         h->version == DNA_BIN_VERSION &&
+         h->encoding == DNA_BIN_ENCODING_2BIT &&
+         h->record_size == sizeof(dna_key);
+}
+
+// texto -> binario. O numero de registros so e conhecido no fim, entao o
+// cabecalho e reescrito depois dos registros
+int text_to_binary(FILE *in, FILE *out) {
+  dna_bin_header h;
+  dna_bin_header_init(&h, 0, 0);
+  if (fwrite(&h, sizeof(h), 1, out) != 1)
+    return 0;
+
+  dna_key *block = (dna_key *)malloc(CONVERT_BLOCK * sizeof(dna_key));
+  if (!block)
+    return 0;
+  // espaco para a maior sequencia aceita, o '\n' e o '\0'
+  char line[DNA_KEY_MAX_BASES + 3];
+  uint64_t count = 0;
+  long long line_number = 0;
+  int length = -1; // -1: nenhuma linha ainda; 0: comprimentos variados
+  int filled = 0;
+  int ok = 1;
+  while (ok && fgets(line, sizeof(line), in)) {
+    line_number++;
+    size_t len = strcspn(line, "\n");
+    if (line[len] != '\n' && !feof(in)) {
+      fprintf(stderr, "Linha %lld maior que %d bases\n", line_number,
+              DNA_KEY_MAX_BASES);
+      ok = 0;
+      break;
+    }
+    if (len == 0)
+      continue;
+    if (!dna_pack_n(line, (int)len, &block[filled])) {
+      fprintf(stderr, "Linha %lld nao e uma sequencia ACGT\n", line_number);
+      ok = 0;
+      break;
+    }
+    if (length == -1)
+      length = (int)len;
+    else if (length != (int)len)
+      length = 0;
+    count++;
+    if (++filled == CONVERT_BLOCK) {
+      ok = fwrite(block, sizeof(dna_key), filled, out) == (size_t)filled;
+      filled = 0;
+    }
+  }
+  if (ok && filled > 0)
+    ok = fwrite(block, sizeof(dna_key), filled, out) == (size_t)filled;
+  free(block);
+  if (!ok)
+    return 0;
+
+  dna_bin_header_init(&h, count, length > 0 ? (uint32_t)length : 0);
+  return fseek(out, 0, SEEK_SET) == 0 && fwrite(&h, sizeof(h), 1, out) == 1;
+}
+
+// binario -> texto, um bloco de registros por vez
+int binary_to_text(FILE *in, FILE *out) {
+  dna_bin_header h;
+  if (fread(&h, sizeof(h), 1, in) != 1 || !dna_bin_header_valid(&h))
+    return 0;
+
+  dna_key *block = (dna_key *)malloc(CONVERT_BLOCK * sizeof(dna_key));
+  if (!block)
+    return 0;
+  char seq[DNA_KEY_MAX_BASES + 1];
+  uint64_t left = h.count;
+  int ok = 1;
+  while (ok && left > 0) {
+    size_t want = left < CONVERT_BLOCK ? (size_t)left : CONVERT_BLOCK;
+    if (fread(block, sizeof(dna_key), want, in) != want) {
+      fprintf(stderr, "Arquivo binario truncado\n");
+      ok = 0;
+      break;
+    }
+    for (size_t i = 0; i < want; i++) {
+      dna_unpack(&block[i], seq);
+      fprintf(out, "%s\n", seq);
+    }
+    left -= want;
+  }
+  free(block);
+  return ok && !ferror(out);
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    printf("Uso: %s <arquivo_entrada> <arquivo_saida>\n", argv[0]);
+    printf("Entrada em texto vira binario e entrada binaria vira texto\n");
+    return 1;
+  }
+
+  FILE *in = fopen(argv[1], "rb");
+  if (!in) {
+    perror("Erro ao abrir arquivo");
+    return 1;
+  }
+  // o formato da entrada sai do cabecalho
+  dna_bin_header h;
+  int binary = fread(&h, sizeof(h), 1, in) == 1 && dna_bin_header_valid(&h);
+  rewind(in);
+
+  FILE *out = fopen(argv[2], binary ? "w" : "wb");
+  if (!out) {
+    perror("Erro ao criar arquivo de saída");
+    fclose(in);
+    return 1;
+  }
+  int ok = binary ? binary_to_text(in, out) : text_to_binary(in, out);
+  fclose(in);
+  if (fclose(out) != 0)
+    ok = 0;
+  if (!ok) {
+    fprintf(stderr, "Erro na conversao de %s\n", argv[1]);
+    return 1;
+  }
+  printf("%s convertido para %s em %s\n", argv[1], binary ? "texto" : "binario",
+         argv[2]);
+  return 0;
+}
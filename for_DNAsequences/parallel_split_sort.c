@@ -1,12 +1,81 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include <mpi.h>
 
 #define SEQ_LENGTH 50
 #define CHUNK_SIZE (SEQ_LENGTH + 1)
 #define DNA_CHARS "ACGT"
+// 32 bases na palavra 0 + 28 na palavra 1; os 8 bits finais guardam o comprimento
+#define DNA_KEY_MAX_BASES 60
+// alinhamento do bloco de registros (linha de cache)
+#define ARENA_ALIGNMENT 64
+// bytes lidos além do fim da faixa para completar a última linha
+#define LINE_OVERLAP (DNA_KEY_MAX_BASES + 1)
+// maior leitura/escrita MPI-IO por chamada (o count é int)
+#define MPIIO_CHUNK (1 << 30)
+// limite de rodadas do histograma (a chave tem 128 bits)
+#define HISTOGRAM_MAX_ROUNDS 160
+
+// sequencia empacotada com 2 bits por base (A=0, C=1, G=2, T=3)
+// a comparacao de (w[0], w[1]) como inteiros sem sinal equivale ao strcmp
+typedef struct {
+    uint64_t w[2];
+} dna_key;
+
+// bloco contiguo e alinhado com todos os registros de um rank
+// e enviado e recebido direto pelo MPI, sem empacotar elemento a elemento
+typedef struct {
+    dna_key* keys;
+    int count;
+    int capacity;
+} dna_arena;
+
+enum output_mode { OUTPUT_GATHER, OUTPUT_MPIIO };
+enum file_format { FORMAT_TEXT, FORMAT_BINARY };
+
+// Arquivo binário: cabeçalho de 32 bytes e depois os registros, cada um um
+// dna_key de 16 bytes como fica na memória (w[0], w[1], little-endian).
+// O registro i começa em sizeof(dna_bin_header) + i * sizeof(dna_key), então
+// cada rank acha a sua faixa por aritmética e lê direto para a arena
+#define DNA_BIN_MAGIC "DNA2BIT"
+#define DNA_BIN_VERSION 1
+#define DNA_BIN_ENCODING_2BIT 1
+
+typedef struct {
+    char magic[8];         // "DNA2BIT\0"
+    uint32_t version;      // DNA_BIN_VERSION
+    uint32_t encoding;     // DNA_BIN_ENCODING_2BIT
+    uint64_t count;        // número de registros
+    uint32_t seq_length;   // comprimento comum das sequências, 0 se variar
+    uint32_t record_size;  // sizeof(dna_key)
+} dna_bin_header;
+
+// redistribuição: Alltoallv e depois intercalação, ou envio em pedaços com
+// intercalação das faixas conforme chegam
+enum exchange_mode { EXCHANGE_ALLTOALL, EXCHANGE_PIPELINE };
+// registros por mensagem no modo pipeline
+#define EXCHANGE_CHUNK (1 << 16)
+
+// escolha dos separadores globais
+typedef struct {
+    int histogram;     // 0: amostras no processo 0; 1: refinamento por histograma
+    double tolerance;  // desvio máximo de cada balde, em fração de n/p (histograma)
+    int oversampling;  // amostras por separador e por processo / sondas por rodada
+} splitter_options;
+
+// a chave vista como um inteiro de 128 bits (mesma ordem do dna_key_cmp)
+typedef unsigned __int128 key_u128;
+
+// separadores como árvore de busca implícita (layout de Eytzinger, raiz no
+// índice 1), completada com a maior chave possível até 2^depth - 1 nós
+typedef struct {
+    dna_key* tree;
+    int depth;
+} splitter_tree;
 
 void generate_dna_sequence(char* seq, int length) {
     for (int i = 0; i < length; i++) {
@@ -15,42 +84,344 @@ void generate_dna_sequence(char* seq, int length) {
     seq[length] = '\0';
 }
 
+static inline int dna_base_code(char c) {
+    switch (c) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+    }
+    return -1;
+}
+
+// empacota a sequencia; retorna 0 se ela nao couber na chave
+int dna_pack(const char* seq, dna_key* key) {
+    key->w[0] = key->w[1] = 0;
+    int i;
+    for (i = 0; seq[i] != '\0'; i++) {
+        int code = dna_base_code(seq[i]);
+        if (code < 0 || i >= DNA_KEY_MAX_BASES) return 0;
+        key->w[i / 32] |= (uint64_t)code << (62 - 2 * (i % 32));
+    }
+    key->w[1] |= (uint64_t)i;
+    return 1;
+}
+
+// número de bases guardado na chave
+static inline int dna_length(const dna_key* key) {
+    int len = (int)(key->w[1] & 0xFF);
+    return len > DNA_KEY_MAX_BASES ? DNA_KEY_MAX_BASES : len;
+}
+
+void dna_bin_header_init(dna_bin_header* h, uint64_t count, uint32_t length) {
+    memset(h, 0, sizeof(*h));
+    memcpy(h->magic, DNA_BIN_MAGIC, sizeof(DNA_BIN_MAGIC));
+    h->version = DNA_BIN_VERSION;
+    h->encoding = DNA_BIN_ENCODING_2BIT;
+    h->count = count;
+    h->seq_length = length;
+    h->record_size = sizeof(dna_key);
+}
+
+int dna_bin_header_valid(const dna_bin_header* h) {
+    return memcmp(h->magic, DNA_BIN_MAGIC, sizeof(DNA_BIN_MAGIC)) == 0 &&
+           h->version == DNA_BIN_VERSION && h->encoding == DNA_BIN_ENCODING_2BIT &&
+           h->record_size == sizeof(dna_key);
+}
+
+// menor e maior comprimento das chaves como {-min, max}, para um MPI_MAX só
+void dna_length_range(const dna_key* keys, int n, int range[2]) {
+    range[0] = -DNA_KEY_MAX_BASES;
+    range[1] = 0;
+    for (int i = 0; i < n; i++) {
+        int len = dna_length(&keys[i]);
+        if (-len > range[0]) range[0] = -len;
+        if (len > range[1]) range[1] = len;
+    }
+}
+
+// desempacota a chave para texto (seq precisa de DNA_KEY_MAX_BASES + 1)
+void dna_unpack(const dna_key* key, char* seq) {
+    int len = dna_length(key);
+    for (int i = 0; i < len; i++) {
+        seq[i] = DNA_CHARS[(key->w[i / 32] >> (62 - 2 * (i % 32))) & 3];
+    }
+    seq[len] = '\0';
+}
+
+static inline int dna_key_cmp(const dna_key* a, const dna_key* b) {
+    if (a->w[0] != b->w[0]) return a->w[0] < b->w[0] ? -1 : 1;
+    if (a->w[1] != b->w[1]) return a->w[1] < b->w[1] ? -1 : 1;
+    return 0;
+}
+
 int compare_dna(const void* a, const void* b) {
-    return strcmp(*(char**)a, *(char**)b);
+    return dna_key_cmp((const dna_key*)a, (const dna_key*)b);
 }
 
-static char* current_flat;  // Para qsort dos splitters (alternativa a qsort_r)
+// Verificação distribuída, sem juntar os dados num processo
+// Resumo de multiconjunto: soma (mod 2^64) de dois hashes de cada chave.
+// A soma não depende da ordem nem de onde a chave está, então o resumo da
+// saída só bate com o da entrada se ela for uma permutação da entrada
+typedef struct {
+    uint64_t h[2];
+    uint64_t count;
+} multiset_digest;
 
-static int my_splitter_compare(const void* pa, const void* pb) {
-    int ia = *(int*)pa;
-    int ib = *(int*)pb;
-    return strcmp(current_flat + ia * CHUNK_SIZE, current_flat + ib * CHUNK_SIZE);
+// finalizador do splitmix64
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
 }
 
-void free_strings(char** arr, int n) {
-    if (arr == NULL) return;
+void digest_keys(const dna_key* keys, int n, multiset_digest* d) {
+    d->h[0] = d->h[1] = 0;
+    d->count = n;
     for (int i = 0; i < n; i++) {
-        free(arr[i]);
+        d->h[0] += mix64(keys[i].w[0] ^ mix64(keys[i].w[1] + 0x9e3779b97f4a7c15ULL));
+        d->h[1] += mix64(keys[i].w[1] ^ mix64(keys[i].w[0] + 0x632be59bd9b4e019ULL));
+    }
+}
+
+// Coletiva. Cada rank confere a própria ordem; as pontas (primeira e última
+// chave) de todos os ranks vêm num Allgather de p registros, e cada um
+// compara a sua primeira com a última do rank não vazio anterior. Os
+// resumos de entrada e saída são somados num único Allreduce
+void verify_sorted(const dna_key* keys, int n, const multiset_digest* input, int* ordered,
+                   int* permutation, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int ok = 1;
+    for (int i = 0; i + 1 < n && ok; i++) {
+        if (dna_key_cmp(&keys[i], &keys[i + 1]) > 0) {
+            fprintf(stderr, "Processo %d: fora de ordem nas posicoes locais %d-%d\n", rank, i,
+                    i + 1);
+            ok = 0;
+        }
+    }
+
+    dna_key ends[2];
+    memset(ends, 0, sizeof(ends));
+    if (n > 0) {
+        ends[0] = keys[0];
+        ends[1] = keys[n - 1];
+    }
+    dna_key* all_ends = malloc(2 * size * sizeof(dna_key));
+    int* all_counts = malloc(size * sizeof(int));
+    MPI_Allgather(ends, 2 * sizeof(dna_key), MPI_BYTE, all_ends, 2 * sizeof(dna_key), MPI_BYTE,
+                  comm);
+    MPI_Allgather(&n, 1, MPI_INT, all_counts, 1, MPI_INT, comm);
+    int previous = rank - 1;
+    while (previous >= 0 && all_counts[previous] == 0) previous--;
+    if (n > 0 && previous >= 0 && dna_key_cmp(&all_ends[2 * previous + 1], &keys[0]) > 0) {
+        fprintf(stderr, "Processo %d: primeira chave menor que a ultima do processo %d\n", rank,
+                previous);
+        ok = 0;
+    }
+    free(all_ends);
+    free(all_counts);
+    MPI_Allreduce(&ok, ordered, 1, MPI_INT, MPI_LAND, comm);
+
+    multiset_digest output;
+    digest_keys(keys, n, &output);
+    uint64_t local_sums[6] = {input->h[0], input->h[1], input->count,
+                              output.h[0], output.h[1], output.count};
+    uint64_t sums[6];
+    MPI_Allreduce(local_sums, sums, 6, MPI_UINT64_T, MPI_SUM, comm);
+    *permutation = sums[0] == sums[3] && sums[1] == sums[4] && sums[2] == sums[5];
+}
+
+static inline key_u128 dna_key_to_u128(const dna_key* key) {
+    return ((key_u128)key->w[0] << 64) | key->w[1];
+}
+
+static inline dna_key dna_key_from_u128(key_u128 v) {
+    dna_key key = {{(uint64_t)(v >> 64), (uint64_t)v}};
+    return key;
+}
+
+// a > b sem desvios, para a descida na árvore de separadores
+static inline int dna_key_gt(const dna_key* a, const dna_key* b) {
+    return (a->w[0] > b->w[0]) | ((a->w[0] == b->w[0]) & (a->w[1] > b->w[1]));
+}
+
+void arena_init(dna_arena* arena, int capacity) {
+    size_t bytes = (size_t)(capacity > 0 ? capacity : 1) * sizeof(dna_key);
+    bytes = (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    arena->keys = aligned_alloc(ARENA_ALIGNMENT, bytes);
+    arena->count = 0;
+    arena->capacity = capacity;
+    if (arena->keys == NULL) {
+        fprintf(stderr, "Erro ao alocar arena de %d registros\n", capacity);
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
-    free(arr);
 }
 
-void imprime(char** lista, int size, int rank) {
-    printf("P%d: [\"", rank);
+void arena_free(dna_arena* arena) {
+    free(arena->keys);
+    arena->keys = NULL;
+    arena->count = arena->capacity = 0;
+}
+
+// troca o conteudo de duas arenas (usado apos a redistribuicao)
+void arena_swap(dna_arena* a, dna_arena* b) {
+    dna_arena tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Linha do tempo (-T arquivo): cada rank registra início e fim de cada etapa,
+// com os bytes enviados e recebidos nela; no fim o processo 0 junta tudo num
+// JSON de eventos do Chrome (chrome://tracing ou ui.perfetto.dev), com um
+// "processo" por rank. Desligada, trace_begin devolve -1 e nada é registrado
+#define TRACE_NAME_LENGTH 32
+
+typedef struct {
+    char name[TRACE_NAME_LENGTH];
+    double start;
+    double end;
+    long long sent;
+    long long received;
+} trace_event;
+
+static trace_event* trace_events = NULL;
+static int trace_count = 0;
+static int trace_capacity = 0;
+static double trace_origin = 0;
+
+// liga a linha do tempo; o instante zero é a saída de uma barreira, então os
+// ranks ficam alinhados mesmo sem relógio global
+void trace_enable(MPI_Comm comm) {
+    trace_capacity = 64;
+    trace_events = malloc(trace_capacity * sizeof(trace_event));
+    MPI_Barrier(comm);
+    trace_origin = MPI_Wtime();
+}
+
+int trace_begin(const char* name) {
+    if (!trace_events) return -1;
+    if (trace_count == trace_capacity) {
+        trace_capacity *= 2;
+        trace_events = realloc(trace_events, trace_capacity * sizeof(trace_event));
+    }
+    trace_event* e = &trace_events[trace_count];
+    snprintf(e->name, TRACE_NAME_LENGTH, "%s", name);
+    e->start = e->end = MPI_Wtime() - trace_origin;
+    e->sent = e->received = 0;
+    return trace_count++;
+}
+
+void trace_end(int id, long long sent, long long received) {
+    if (id < 0) return;
+    trace_events[id].end = MPI_Wtime() - trace_origin;
+    trace_events[id].sent = sent;
+    trace_events[id].received = received;
+}
+
+// Coletiva: cada rank formata os seus eventos ("X", tempos em µs) e o
+// processo 0 recebe os textos com um Gatherv e grava o arquivo
+void trace_write(const char* filename, MPI_Comm comm) {
+    if (!trace_events) return;
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int capacity = (trace_count + 1) * 256;
+    char* text = malloc(capacity);
+    int length = snprintf(text, capacity,
+                          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                          "\"args\":{\"name\":\"rank %d\"}},\n", rank, rank);
+    for (int i = 0; i < trace_count; i++) {
+        const trace_event* e = &trace_events[i];
+        length += snprintf(text + length, capacity - length,
+                           "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,"
+                           "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes_enviados\":%lld,"
+                           "\"bytes_recebidos\":%lld}},\n",
+                           e->name, rank, e->start * 1e6, (e->end - e->start) * 1e6,
+                           e->sent, e->received);
+    }
+
+    int* lengths = NULL;
+    int* displs = NULL;
+    char* all = NULL;
+    if (rank == 0) lengths = malloc(size * sizeof(int));
+    MPI_Gather(&length, 1, MPI_INT, lengths, 1, MPI_INT, 0, comm);
+    int total = 0;
+    if (rank == 0) {
+        displs = malloc(size * sizeof(int));
+        for (int p = 0; p < size; p++) {
+            displs[p] = total;
+            total += lengths[p];
+        }
+        all = malloc(total);
+    }
+    MPI_Gatherv(text, length, MPI_CHAR, all, lengths, displs, MPI_CHAR, 0, comm);
+
+    if (rank == 0) {
+        FILE* out = fopen(filename, "w");
+        if (out) {
+            // o último evento termina em ",\n"; a vírgula sai antes do "]"
+            fprintf(out, "{\"traceEvents\":[\n");
+            fwrite(all, 1, total - 2, out);
+            fprintf(out, "\n]}\n");
+            fclose(out);
+        } else {
+            fprintf(stderr, "Erro ao criar arquivo %s\n", filename);
+        }
+        free(lengths);
+        free(displs);
+        free(all);
+    }
+    free(text);
+    free(trace_events);
+    trace_events = NULL;
+    trace_count = trace_capacity = 0;
+}
+
+// -q: listas viram só a contagem (medições com n grande)
+static int quiet = 0;
+
+void imprime_keys(dna_key* lista, int size, int rank) {
+    if (quiet) {
+        printf("P%d: [%d sequencias]\n", rank, size);
+        return;
+    }
+    char seq[DNA_KEY_MAX_BASES + 1];
+    printf("P%d: [", rank);
     for (int i = 0; i < size; i++) {
-        printf("%s\"", lista[i]);
+        dna_unpack(&lista[i], seq);
+        printf("\"%s\"", seq);
         if (i < size - 1) printf(", ");
     }
     printf("]\n");
 }
 
-void parallel_splitsort(char*** local_arr_ptr, int* local_n, MPI_Comm comm);
+void read_dna_file_mpiio(const char* filename, dna_arena* local, MPI_Comm comm);
+void write_dna_file_mpiio(const char* filename, const dna_key* keys, int count, MPI_Comm comm);
+void write_dna_binary_mpiio(const char* filename, const dna_key* keys, int count, MPI_Comm comm);
+void build_splitter_tree(splitter_tree* st, const dna_key* splitters, int num_splitters);
+void classify_keys(const splitter_tree* st, const dna_key* keys, int n, int* counts);
+void merge_runs(const dna_key* src, const int* counts, const int* displs, int runs, dna_key* dst);
+void exchange_and_merge(const dna_key* send, const int* send_counts, const int* send_displs,
+                        const int* recv_counts, const int* recv_displs, dna_key* dst,
+                        MPI_Comm comm);
+int histogram_splitters(const dna_key* sorted, int n, dna_key* global_splitters,
+                        const splitter_options* opts, MPI_Comm comm);
+void split_ties(const dna_key* sorted, int n, const dna_key* splitters, int num_splitters,
+                int* cut, MPI_Comm comm);
+void parallel_splitsort(dna_arena* local, const splitter_options* opts, int exchange,
+                        MPI_Comm comm);
 
 int main(int argc, char* argv[]) {
     int rank, size;
-    char** local_arr = NULL;
-    int local_n;
-    int total_n = 100000;  // Ajuste para 100k, 1M, 10M nos experimentos
+    dna_arena local;
+    int total_n = 100000;  // sem arquivo de entrada: -n sequencias geradas
 
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -58,195 +429,1010 @@ int main(int argc, char* argv[]) {
 
     srand(time(NULL) + rank);  // Semente única por rank
 
-    if (argc > 1) {
-        // Suporte a arquivo: rank 0 lê e conta linhas
+    // -o mpiio: cada rank escreve o seu trecho em output.txt, sem coleta no 0
+    // -s amostra|histograma, -b tolerancia, -a sobreamostragem: separadores
+    int output = OUTPUT_GATHER;
+    // -x alltoall|pipeline: redistribuição em bloco ou em pedaços sobrepostos
+    // -n sequencias (sem arquivo de entrada), -q: sem listar as sequências
+    // -T arquivo: linha do tempo por rank em JSON de eventos do Chrome
+    // -v: confere ordem e permutação da saída sem juntar os dados
+    // -f texto|binario: formato da saída (output.txt ou output.bin); a
+    // entrada binária é reconhecida pelo cabeçalho
+    splitter_options opts = {0, 0.05, 1};
+    int exchange = EXCHANGE_ALLTOALL;
+    const char* trace_file = NULL;
+    int verify = 0;
+    int format = FORMAT_TEXT;
+    int opt;
+    int usage = 0;
+    while ((opt = getopt(argc, argv, "o:s:b:a:x:n:qT:vf:")) != -1) {
+        if (opt == 'o' && strcmp(optarg, "gather") == 0) {
+            output = OUTPUT_GATHER;
+        } else if (opt == 'o' && strcmp(optarg, "mpiio") == 0) {
+            output = OUTPUT_MPIIO;
+        } else if (opt == 's' && strcmp(optarg, "amostra") == 0) {
+            opts.histogram = 0;
+        } else if (opt == 's' && strcmp(optarg, "histograma") == 0) {
+            opts.histogram = 1;
+        } else if (opt == 'b' && atof(optarg) > 0) {
+            opts.tolerance = atof(optarg);
+        } else if (opt == 'a' && atoi(optarg) > 0) {
+            opts.oversampling = atoi(optarg);
+        } else if (opt == 'x' && strcmp(optarg, "alltoall") == 0) {
+            exchange = EXCHANGE_ALLTOALL;
+        } else if (opt == 'x' && strcmp(optarg, "pipeline") == 0) {
+            exchange = EXCHANGE_PIPELINE;
+        } else if (opt == 'n' && atoi(optarg) > 0) {
+            total_n = atoi(optarg);
+        } else if (opt == 'q') {
+            quiet = 1;
+        } else if (opt == 'T') {
+            trace_file = optarg;
+        } else if (opt == 'v') {
+            verify = 1;
+        } else if (opt == 'f' && strcmp(optarg, "texto") == 0) {
+            format = FORMAT_TEXT;
+        } else if (opt == 'f' && strcmp(optarg, "binario") == 0) {
+            format = FORMAT_BINARY;
+        } else {
+            usage = 1;
+        }
+    }
+    if (usage) {
         if (rank == 0) {
-            FILE* in = fopen(argv[1], "r");
-            if (in) {
-                char line[SEQ_LENGTH + 2];
-                total_n = 0;
-                while (fgets(line, sizeof(line), in)) {
-                    total_n++;
-                }
-                rewind(in);
-                // Aqui você pode ler para global_arr; por simplicidade, gera aleatório se arquivo inválido
-                fclose(in);
+            printf("Uso: %s [-o gather|mpiio] [-s amostra|histograma] [-b tolerancia] "
+                   "[-a sobreamostragem] [-x alltoall|pipeline] [-n sequencias] [-q] "
+                   "[-T linha_do_tempo.json] [-v] [-f texto|binario] [arquivo_entrada]\n", argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    const char* input_file = optind < argc ? argv[optind] : NULL;
+    const char* output_file = format == FORMAT_BINARY ? "output.bin" : "output.txt";
+    if (trace_file) trace_enable(MPI_COMM_WORLD);
+
+    int* counts = malloc(size * sizeof(int));
+    int* displs = malloc(size * sizeof(int));
+
+    if (input_file) {
+        // Cada rank lê a sua faixa do arquivo; nenhum rank carrega tudo
+        int t = trace_begin("leitura");
+        read_dna_file_mpiio(input_file, &local, MPI_COMM_WORLD);
+        trace_end(t, 0, 0);
+        int local_count = local.count;
+        MPI_Allreduce(&local_count, &total_n, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        if (rank == 0) {
+            printf("Processo %d: %d sequencias lidas de %s\n", rank, total_n, input_file);
+        }
+    } else {
+        // Distribuição em bytes; os primeiros ranks ficam com o resto
+        for (int p = 0; p < size; p++) {
+            int n_p = total_n / size + (p < total_n % size ? 1 : 0);
+            counts[p] = n_p * sizeof(dna_key);
+            displs[p] = p == 0 ? 0 : displs[p - 1] + counts[p - 1];
+        }
+
+        arena_init(&local, counts[rank] / sizeof(dna_key));
+        local.count = counts[rank] / sizeof(dna_key);
+
+        if (rank == 0) {
+            // gera direto na arena global, ja empacotado
+            dna_arena global;
+            arena_init(&global, total_n);
+            char seq[CHUNK_SIZE];
+            for (int i = 0; i < total_n; i++) {
+                generate_dna_sequence(seq, SEQ_LENGTH);
+                dna_pack(seq, &global.keys[i]);
             }
+            global.count = total_n;
+
+            printf("Processo %d: Dados globais originais:\n", rank);
+            imprime_keys(global.keys, total_n, rank);
+
+            MPI_Scatterv(global.keys, counts, displs, MPI_BYTE,
+                         local.keys, counts[rank], MPI_BYTE, 0, MPI_COMM_WORLD);
+            arena_free(&global);
+        } else {
+            MPI_Scatterv(NULL, NULL, NULL, MPI_BYTE,
+                         local.keys, counts[rank], MPI_BYTE, 0, MPI_COMM_WORLD);
         }
-        MPI_Bcast(&total_n, 1, MPI_INT, 0, MPI_COMM_WORLD);
     }
 
-    local_n = total_n / size;
+    multiset_digest input_digest;
+    if (verify) digest_keys(local.keys, local.count, &input_digest);
 
+    // Tempo de parede da ordenação (leitura e escrita ficam de fora)
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
+    parallel_splitsort(&local, &opts, exchange, MPI_COMM_WORLD);
+    double sort_time = MPI_Wtime() - start_time, max_time;
+    MPI_Reduce(&sort_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
     if (rank == 0) {
-        char** global_arr = malloc(total_n * sizeof(char*));
-        for (int i = 0; i < total_n; i++) {
-            global_arr[i] = malloc(CHUNK_SIZE);
-            generate_dna_sequence(global_arr[i], SEQ_LENGTH);
+        printf("Processo %d: Tempo de execucao: %.6f segundos\n", rank, max_time);
+    }
+
+    if (verify) {
+        int ordered, permutation;
+        int t = trace_begin("verificacao");
+        verify_sorted(local.keys, local.count, &input_digest, &ordered, &permutation,
+                      MPI_COMM_WORLD);
+        trace_end(t, 0, 0);
+        if (rank == 0) {
+            printf("Processo %d: Verificacao: ordem %s, permutacao da entrada %s\n", rank,
+                   ordered ? "CORRETO" : "INCORRETO", permutation ? "CORRETO" : "INCORRETO");
         }
+    }
 
-        printf("Processo %d: Dados globais originais:\n", rank);
-        imprime(global_arr, total_n, rank);
+    if (output == OUTPUT_MPIIO) {
+        // Saída paralela: cada rank escreve direto no seu deslocamento do arquivo
+        int t = trace_begin("escrita");
+        if (format == FORMAT_BINARY) {
+            write_dna_binary_mpiio(output_file, local.keys, local.count, MPI_COMM_WORLD);
+        } else {
+            write_dna_file_mpiio(output_file, local.keys, local.count, MPI_COMM_WORLD);
+        }
+        trace_end(t, 0, 0);
+        if (rank == 0) {
+            printf("\nProcesso %d: %d sequencias ordenadas escritas em %s\n",
+                   rank, total_n, output_file);
+        }
+    } else {
+        // Coleta: tamanhos finais e depois os registros direto na arena de saída
+        int local_bytes = local.count * sizeof(dna_key);
+        MPI_Gather(&local_bytes, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            displs[0] = 0;
+            for (int p = 1; p < size; p++) {
+                displs[p] = displs[p - 1] + counts[p - 1];
+            }
+
+            dna_arena sorted_global;
+            arena_init(&sorted_global, total_n);
+            MPI_Gatherv(local.keys, local_bytes, MPI_BYTE,
+                        sorted_global.keys, counts, displs, MPI_BYTE, 0, MPI_COMM_WORLD);
+            sorted_global.count = total_n;
+
+            // as chaves so voltam a ser texto na saida; no binario vao como estao
+            FILE* out = fopen(output_file, "w");
+            if (format == FORMAT_BINARY) {
+                int range[2];
+                dna_length_range(sorted_global.keys, total_n, range);
+                dna_bin_header h;
+                dna_bin_header_init(&h, total_n, -range[0] == range[1] ? range[1] : 0);
+                fwrite(&h, sizeof(h), 1, out);
+                fwrite(sorted_global.keys, sizeof(dna_key), total_n, out);
+            } else {
+                char seq[DNA_KEY_MAX_BASES + 1];
+                for (int i = 0; i < total_n; i++) {
+                    dna_unpack(&sorted_global.keys[i], seq);
+                    fprintf(out, "%s\n", seq);
+                }
+            }
+            fclose(out);
 
-        local_arr = malloc(local_n * sizeof(char*));
-        for (int i = 0; i < local_n; i++) {
-            local_arr[i] = malloc(CHUNK_SIZE);
-            strcpy(local_arr[i], global_arr[i]);
+            printf("\nProcesso %d: Dados globais ordenados:\n", rank);
+            imprime_keys(sorted_global.keys, total_n, rank);
+
+            arena_free(&sorted_global);
+        } else {
+            MPI_Gatherv(local.keys, local_bytes, MPI_BYTE,
+                        NULL, NULL, NULL, MPI_BYTE, 0, MPI_COMM_WORLD);
         }
+    }
+
+    if (trace_file) {
+        trace_write(trace_file, MPI_COMM_WORLD);
+        if (rank == 0) printf("Processo %d: Linha do tempo em %s\n", rank, trace_file);
+    }
+
+    free(counts);
+    free(displs);
+    arena_free(&local);
+    MPI_Finalize();
+    return 0;
+}
+
+// Leitura do formato binário: o rank r fica com os registros
+// [count * r / p, count * (r + 1) / p), lidos direto para a arena, sem
+// procurar quebras de linha nem empacotar
+static void read_dna_binary_mpiio(MPI_File fh, const dna_bin_header* h, MPI_Offset file_size,
+                                  dna_arena* local, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    long long count = (long long)h->count;
+    MPI_Offset header = sizeof(dna_bin_header);
+    if (count < 0 || (file_size - header) / (MPI_Offset)sizeof(dna_key) < count) {
+        if (rank == 0) fprintf(stderr, "Arquivo binario truncado: %lld registros no cabecalho\n",
+                               count);
+        MPI_Abort(comm, 1);
+    }
+    long long first = count * rank / size;
+    long long last = count * (rank + 1) / size;
+    arena_init(local, (int)(last - first));
+    local->count = (int)(last - first);
+
+    // leitura coletiva em blocos; todos fazem o mesmo número de chamadas
+    long long bytes = (last - first) * (long long)sizeof(dna_key);
+    long long rounds = (bytes + MPIIO_CHUNK - 1) / MPIIO_CHUNK;
+    long long max_rounds;
+    MPI_Allreduce(&rounds, &max_rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    char* buffer = (char*)local->keys;
+    long long done = 0;
+    for (long long r = 0; r < max_rounds; r++) {
+        int chunk = bytes - done < MPIIO_CHUNK ? (int)(bytes - done) : MPIIO_CHUNK;
+        MPI_File_read_at_all(fh, header + first * (MPI_Offset)sizeof(dna_key) + done,
+                             buffer + done, chunk, MPI_BYTE, MPI_STATUS_IGNORE);
+        done += chunk;
+    }
+}
+
+// Leitura paralela com MPI-IO: o arquivo é dividido em faixas de bytes iguais
+// e cada rank fica com as linhas que começam dentro da sua faixa. Lê também o
+// byte anterior (para saber se a faixa começa no meio de uma linha) e até
+// LINE_OVERLAP bytes depois do fim (para completar a última linha)
+void read_dna_file_mpiio(const char* filename, dna_arena* local, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    MPI_File fh;
+    if (MPI_File_open(comm, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        if (rank == 0) fprintf(stderr, "Erro ao abrir arquivo %s\n", filename);
+        MPI_Abort(comm, 1);
+    }
+    MPI_Offset file_size;
+    MPI_File_get_size(fh, &file_size);
+
+    // arquivo binário: reconhecido pela assinatura do cabeçalho
+    dna_bin_header h;
+    memset(&h, 0, sizeof(h));
+    if (file_size >= (MPI_Offset)sizeof(h)) {
+        MPI_File_read_at_all(fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    if (dna_bin_header_valid(&h)) {
+        read_dna_binary_mpiio(fh, &h, file_size, local, comm);
+        MPI_File_close(&fh);
+        return;
+    }
+
+    MPI_Offset begin = file_size * rank / size;
+    MPI_Offset end = file_size * (rank + 1) / size;
+    MPI_Offset read_begin = begin > 0 ? begin - 1 : 0;
+    MPI_Offset read_end = end + LINE_OVERLAP < file_size ? end + LINE_OVERLAP : file_size;
+    if (begin == end) read_begin = read_end = begin;
+    MPI_Offset read_len = read_end - read_begin;
 
-        for (int p = 1; p < size; p++) {
-            char* pack = malloc(local_n * CHUNK_SIZE);
-            for (int j = 0; j < local_n; j++) {
-                memcpy(pack + j * CHUNK_SIZE, global_arr[p * local_n + j], CHUNK_SIZE);
+    char* buffer = malloc(read_len + 1);
+    if (buffer == NULL) {
+        fprintf(stderr, "Processo %d: erro ao alocar %lld bytes de leitura\n",
+                rank, (long long)read_len);
+        MPI_Abort(comm, 1);
+    }
+
+    // leitura coletiva em blocos; todos fazem o mesmo número de chamadas
+    long long rounds = (read_len + MPIIO_CHUNK - 1) / MPIIO_CHUNK;
+    long long max_rounds;
+    MPI_Allreduce(&rounds, &max_rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    MPI_Offset done = 0;
+    for (long long r = 0; r < max_rounds; r++) {
+        int chunk = read_len - done < MPIIO_CHUNK ? (int)(read_len - done) : MPIIO_CHUNK;
+        MPI_File_read_at_all(fh, read_begin + done, buffer + done, chunk, MPI_BYTE,
+                             MPI_STATUS_IGNORE);
+        done += chunk;
+    }
+    MPI_File_close(&fh);
+
+    // primeira linha que começa dentro da faixa
+    MPI_Offset first = begin;
+    while (first > 0 && first < end && buffer[first - 1 - read_begin] != '\n') {
+        first++;
+    }
+
+    // 1ª passada conta as linhas, 2ª empacota direto na arena
+    for (int pass = 0; pass < 2; pass++) {
+        int count = 0;
+        MPI_Offset pos = first;
+        while (pos < end) {
+            char* line = buffer + (pos - read_begin);
+            char* nl = memchr(line, '\n', read_end - pos);
+            if (nl == NULL && read_end < file_size) {
+                fprintf(stderr, "Processo %d: linha maior que %d bases no byte %lld\n",
+                        rank, DNA_KEY_MAX_BASES, (long long)pos);
+                MPI_Abort(comm, 1);
+            }
+            int len = nl ? (int)(nl - line) : (int)(read_end - pos);
+            if (len > 0) {
+                if (pass == 1) {
+                    line[len] = '\0';
+                    if (!dna_pack(line, &local->keys[count])) {
+                        fprintf(stderr, "Processo %d: linha invalida no byte %lld\n",
+                                rank, (long long)pos);
+                        MPI_Abort(comm, 1);
+                    }
+                }
+                count++;
             }
-            MPI_Send(pack, local_n * CHUNK_SIZE, MPI_CHAR, p, 0, MPI_COMM_WORLD);
-            free(pack);
+            pos += len + 1;
         }
+        if (pass == 0) arena_init(local, count);
+        else local->count = count;
+    }
+
+    free(buffer);
+}
+
+// Escrita paralela com MPI-IO: cada rank decodifica o seu trecho ordenado,
+// acha o seu deslocamento no arquivo com a soma de prefixo exclusiva dos
+// tamanhos em bytes (MPI_Exscan) e escreve na posição certa com uma escrita
+// coletiva. Como os ranks estão em ordem global, o arquivo sai ordenado
+void write_dna_file_mpiio(const char* filename, const dna_key* keys, int count, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    long long bytes = 0;
+    for (int i = 0; i < count; i++) {
+        bytes += dna_length(&keys[i]) + 1;
+    }
+    char* text = malloc(bytes + 1);
+    if (text == NULL) {
+        fprintf(stderr, "Processo %d: erro ao alocar %lld bytes de saida\n", rank, bytes);
+        MPI_Abort(comm, 1);
+    }
+    char* p = text;
+    for (int i = 0; i < count; i++) {
+        int len = dna_length(&keys[i]);
+        dna_unpack(&keys[i], p);
+        p[len] = '\n';
+        p += len + 1;
+    }
+
+    long long offset = 0, total = 0;
+    MPI_Exscan(&bytes, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) offset = 0;  // Exscan não define o valor no rank 0
+    MPI_Allreduce(&bytes, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+    MPI_File fh;
+    if (MPI_File_open(comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                      &fh) != MPI_SUCCESS) {
+        if (rank == 0) fprintf(stderr, "Erro ao criar arquivo %s\n", filename);
+        MPI_Abort(comm, 1);
+    }
+    // descarta o conteúdo de execuções anteriores mais longas
+    MPI_File_set_size(fh, total);
+
+    long long rounds = (bytes + MPIIO_CHUNK - 1) / MPIIO_CHUNK;
+    long long max_rounds;
+    MPI_Allreduce(&rounds, &max_rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    long long done = 0;
+    for (long long r = 0; r < max_rounds; r++) {
+        int chunk = bytes - done < MPIIO_CHUNK ? (int)(bytes - done) : MPIIO_CHUNK;
+        MPI_File_write_at_all(fh, offset + done, text + done, chunk, MPI_BYTE,
+                              MPI_STATUS_IGNORE);
+        done += chunk;
+    }
+    MPI_File_close(&fh);
+    free(text);
+}
+
+// Escrita paralela do formato binário: o deslocamento de cada rank sai da
+// soma de prefixo das contagens, sem decodificar nada; o processo 0 grava
+// o cabeçalho com o total e o comprimento comum (0 se variar)
+void write_dna_binary_mpiio(const char* filename, const dna_key* keys, int count, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    long long n = count, first = 0, total = 0;
+    MPI_Exscan(&n, &first, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) first = 0;  // Exscan não define o valor no rank 0
+    MPI_Allreduce(&n, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    int range[2], global_range[2];
+    dna_length_range(keys, count, range);
+    MPI_Allreduce(range, global_range, 2, MPI_INT, MPI_MAX, comm);
+
+    MPI_File fh;
+    if (MPI_File_open(comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                      &fh) != MPI_SUCCESS) {
+        if (rank == 0) fprintf(stderr, "Erro ao criar arquivo %s\n", filename);
+        MPI_Abort(comm, 1);
+    }
+    MPI_Offset header = sizeof(dna_bin_header);
+    MPI_File_set_size(fh, header + total * (MPI_Offset)sizeof(dna_key));
+    if (rank == 0) {
+        dna_bin_header h;
+        dna_bin_header_init(&h, total,
+                            -global_range[0] == global_range[1] ? global_range[1] : 0);
+        MPI_File_write_at(fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+
+    long long bytes = n * (long long)sizeof(dna_key);
+    long long rounds = (bytes + MPIIO_CHUNK - 1) / MPIIO_CHUNK;
+    long long max_rounds;
+    MPI_Allreduce(&rounds, &max_rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    const char* data = (const char*)keys;
+    long long done = 0;
+    for (long long r = 0; r < max_rounds; r++) {
+        int chunk = bytes - done < MPIIO_CHUNK ? (int)(bytes - done) : MPIIO_CHUNK;
+        MPI_File_write_at_all(fh, header + first * (MPI_Offset)sizeof(dna_key) + done,
+                              data + done, chunk, MPI_BYTE, MPI_STATUS_IGNORE);
+        done += chunk;
+    }
+    MPI_File_close(&fh);
+}
 
-        free_strings(global_arr, total_n);
+// preenche a árvore em ordem (esquerda, nó, direita) com os separadores
+// ordenados; os nós que sobram recebem a maior chave, que nenhuma supera
+static int fill_tree(dna_key* tree, int nodes, int j, const dna_key* sorted, int num_sorted, int i) {
+    if (j > nodes) return i;
+    i = fill_tree(tree, nodes, 2 * j, sorted, num_sorted, i);
+    if (i < num_sorted) {
+        tree[j] = sorted[i];
     } else {
-        local_arr = malloc(local_n * sizeof(char*));
-        char* recv_pack = malloc(local_n * CHUNK_SIZE);
-        MPI_Recv(recv_pack, local_n * CHUNK_SIZE, MPI_CHAR, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        for (int j = 0; j < local_n; j++) {
-            local_arr[j] = malloc(CHUNK_SIZE);
-            memcpy(local_arr[j], recv_pack + j * CHUNK_SIZE, CHUNK_SIZE);
+        tree[j].w[0] = tree[j].w[1] = UINT64_MAX;
+    }
+    i++;
+    return fill_tree(tree, nodes, 2 * j + 1, sorted, num_sorted, i);
+}
+
+void build_splitter_tree(splitter_tree* st, const dna_key* splitters, int num_splitters) {
+    st->depth = 0;
+    while ((1 << st->depth) - 1 < num_splitters) st->depth++;
+    int nodes = (1 << st->depth) - 1;
+    st->tree = malloc((nodes + 1) * sizeof(dna_key));
+    fill_tree(st->tree, nodes, 1, splitters, num_splitters, 0);
+}
+
+// Conta os registros por destino. Destino = quantos separadores são menores
+// que a chave (a mesma regra da busca linear); a descida não tem desvios,
+// j = 2j + (chave > tree[j]), e quatro chaves descem juntas
+void classify_keys(const splitter_tree* st, const dna_key* keys, int n, int* counts) {
+    const dna_key* tree = st->tree;
+    int depth = st->depth;
+    int leaves = 1 << depth;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int j0 = 1, j1 = 1, j2 = 1, j3 = 1;
+        for (int l = 0; l < depth; l++) {
+            j0 = 2 * j0 + dna_key_gt(&keys[i], &tree[j0]);
+            j1 = 2 * j1 + dna_key_gt(&keys[i + 1], &tree[j1]);
+            j2 = 2 * j2 + dna_key_gt(&keys[i + 2], &tree[j2]);
+            j3 = 2 * j3 + dna_key_gt(&keys[i + 3], &tree[j3]);
         }
-        free(recv_pack);
+        counts[j0 - leaves]++;
+        counts[j1 - leaves]++;
+        counts[j2 - leaves]++;
+        counts[j3 - leaves]++;
     }
+    for (; i < n; i++) {
+        int j = 1;
+        for (int l = 0; l < depth; l++) {
+            j = 2 * j + dna_key_gt(&keys[i], &tree[j]);
+        }
+        counts[j - leaves]++;
+    }
+}
 
-    parallel_splitsort(&local_arr, &local_n, MPI_COMM_WORLD);
+// faixa ordenada ainda não consumida, para a intercalação
+typedef struct {
+    const dna_key* pos;
+    const dna_key* end;
+} merge_run;
 
-    if (rank == 0) {
-        char** sorted_global = malloc(total_n * sizeof(char*));
-        int* recv_counts = malloc(size * sizeof(int));
-        int* recv_displs = malloc(size * sizeof(int));
+// a run a sai antes da b? Faixa esgotada perde sempre; empate fica com a
+// de menor índice
+static inline int run_before(const merge_run* runs, int a, int b) {
+    if (runs[b].pos == runs[b].end) return 1;
+    if (runs[a].pos == runs[a].end) return 0;
+    int cmp = dna_key_cmp(runs[a].pos, runs[b].pos);
+    return cmp < 0 || (cmp == 0 && a < b);
+}
 
-        recv_counts[0] = local_n;
-        for (int i = 1; i < size; i++) {
-            MPI_Recv(&recv_counts[i], 1, MPI_INT, i, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+// Intercala as faixas ordenadas list[0..runs) em dst com uma árvore de
+// perdedores: tree[0] guarda a vencedora e cada nó interno a perdedora do
+// seu jogo. Depois de tirar a chave da vencedora só o caminho da folha dela
+// até a raiz é rejogado, log2(runs) comparações
+static void merge_run_list(const merge_run* list, int runs, dna_key* dst) {
+    int leaves = 1;
+    while (leaves < runs) leaves <<= 1;
+    merge_run* run = malloc(leaves * sizeof(merge_run));
+    int* tree = malloc(leaves * sizeof(int));
+    int* winner = malloc(2 * leaves * sizeof(int));
+    long long total = 0;
+    for (int r = 0; r < leaves; r++) {
+        // folhas que sobram são faixas vazias
+        if (r < runs) {
+            run[r] = list[r];
+        } else {
+            run[r].pos = run[r].end = NULL;
         }
+        winner[leaves + r] = r;
+        total += run[r].end - run[r].pos;
+    }
+    for (int j = leaves - 1; j >= 1; j--) {
+        int a = winner[2 * j], b = winner[2 * j + 1];
+        int a_wins = run_before(run, a, b);
+        winner[j] = a_wins ? a : b;
+        tree[j] = a_wins ? b : a;
+    }
+    tree[0] = winner[1];
+    free(winner);
 
-        recv_displs[0] = 0;
-        for (int i = 1; i < size; i++) {
-            recv_displs[i] = recv_displs[i - 1] + recv_counts[i - 1];
+    for (long long out = 0; out < total; out++) {
+        int w = tree[0];
+        dst[out] = *run[w].pos++;
+        for (int j = (leaves + w) >> 1; j >= 1; j >>= 1) {
+            if (run_before(run, tree[j], w)) {
+                int loser = w;
+                w = tree[j];
+                tree[j] = loser;
+            }
         }
+        tree[0] = w;
+    }
 
-        for (int i = 0; i < local_n; i++) {
-            sorted_global[i] = malloc(CHUNK_SIZE);
-            strcpy(sorted_global[i], local_arr[i]);
+    free(run);
+    free(tree);
+}
+
+// Intercala `runs` faixas ordenadas de src (counts/displs em registros) em dst
+void merge_runs(const dna_key* src, const int* counts, const int* displs, int runs, dna_key* dst) {
+    merge_run* list = malloc((runs > 0 ? runs : 1) * sizeof(merge_run));
+    for (int r = 0; r < runs; r++) {
+        list[r].pos = src + displs[r];
+        list[r].end = list[r].pos + counts[r];
+    }
+    merge_run_list(list, runs, dst);
+    free(list);
+}
+
+// faixa já intercalada à espera de outra do mesmo nível (contador binário:
+// duas faixas de nível l viram uma de nível l+1, total O(n log p))
+typedef struct {
+    merge_run run;
+    int level;
+    dna_key* owned;  // buffer próprio, ou NULL se aponta para a recepção
+} pending_run;
+
+// empilha uma faixa completa, intercalando com o topo enquanto os níveis
+// coincidirem
+static void push_run(pending_run* stack, int* top, const dna_key* keys, int count) {
+    if (count == 0) return;
+    pending_run item = {{keys, keys + count}, 0, NULL};
+    while (*top > 0 && stack[*top - 1].level == item.level) {
+        pending_run* below = &stack[--*top];
+        merge_run pair[2] = {below->run, item.run};
+        long long total = (pair[0].end - pair[0].pos) + (pair[1].end - pair[1].pos);
+        dna_key* buffer = malloc(total * sizeof(dna_key));
+        merge_run_list(pair, 2, buffer);
+        free(below->owned);
+        free(item.owned);
+        item.run.pos = buffer;
+        item.run.end = buffer + total;
+        item.level++;
+        item.owned = buffer;
+    }
+    stack[(*top)++] = item;
+}
+
+// Redistribuição em pedaços de EXCHANGE_CHUNK registros com MPI_Isend/
+// MPI_Irecv, intercalando as faixas conforme chegam. Cada faixa completa
+// entra numa pilha de níveis e é intercalada com a do topo enquanto os
+// níveis coincidirem, então o trabalho de intercalação acontece com o resto
+// ainda em trânsito; no fim, as poucas faixas da pilha (no máximo
+// log2(p) + 1) vão para dst numa árvore de perdedores
+void exchange_and_merge(const dna_key* send, const int* send_counts, const int* send_displs,
+                        const int* recv_counts, const int* recv_displs, dna_key* dst,
+                        MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int total_recv = recv_displs[size - 1] + recv_counts[size - 1];
+    dna_key* recv = malloc((total_recv > 0 ? total_recv : 1) * sizeof(dna_key));
+
+    int num_recv = 0, num_send = 0;
+    for (int p = 0; p < size; p++) {
+        if (p == rank) continue;
+        num_recv += (recv_counts[p] + EXCHANGE_CHUNK - 1) / EXCHANGE_CHUNK;
+        num_send += (send_counts[p] + EXCHANGE_CHUNK - 1) / EXCHANGE_CHUNK;
+    }
+    MPI_Request* recv_req = malloc((num_recv > 0 ? num_recv : 1) * sizeof(MPI_Request));
+    MPI_Request* send_req = malloc((num_send > 0 ? num_send : 1) * sizeof(MPI_Request));
+    int* recv_source = malloc((num_recv > 0 ? num_recv : 1) * sizeof(int));
+    int* chunks_left = calloc(size, sizeof(int));
+
+    // recepções primeiro; envios começam pelo vizinho seguinte para não
+    // caírem todos no mesmo processo ao mesmo tempo
+    int r = 0;
+    for (int step = 1; step < size; step++) {
+        int p = (rank - step + size) % size;
+        for (int off = 0; off < recv_counts[p]; off += EXCHANGE_CHUNK) {
+            int chunk = recv_counts[p] - off < EXCHANGE_CHUNK ? recv_counts[p] - off : EXCHANGE_CHUNK;
+            MPI_Irecv(recv + recv_displs[p] + off, chunk * sizeof(dna_key), MPI_BYTE, p, 0, comm,
+                      &recv_req[r]);
+            recv_source[r++] = p;
+            chunks_left[p]++;
         }
+    }
+    int s = 0;
+    for (int step = 1; step < size; step++) {
+        int p = (rank + step) % size;
+        for (int off = 0; off < send_counts[p]; off += EXCHANGE_CHUNK) {
+            int chunk = send_counts[p] - off < EXCHANGE_CHUNK ? send_counts[p] - off : EXCHANGE_CHUNK;
+            MPI_Isend(send + send_displs[p] + off, chunk * sizeof(dna_key), MPI_BYTE, p, 0, comm,
+                      &send_req[s++]);
+        }
+    }
 
-        for (int p = 1; p < size; p++) {
-            int rcount = recv_counts[p];
-            char* temp_pack = malloc(rcount * CHUNK_SIZE);
-            MPI_Recv(temp_pack, rcount * CHUNK_SIZE, MPI_CHAR, p, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            for (int j = 0; j < rcount; j++) {
-                int gidx = recv_displs[p] + j;
-                sorted_global[gidx] = malloc(CHUNK_SIZE);
-                memcpy(sorted_global[gidx], temp_pack + j * CHUNK_SIZE, CHUNK_SIZE);
+    // a faixa do próprio processo já está pronta, direto do envio; as outras
+    // entram quando o último pedaço delas chega
+    pending_run* stack = malloc((size + 1) * sizeof(pending_run));
+    int top = 0;
+    push_run(stack, &top, send + send_displs[rank], send_counts[rank]);
+    for (int arrived = 0; arrived < num_recv; arrived++) {
+        int done;
+        MPI_Waitany(num_recv, recv_req, &done, MPI_STATUS_IGNORE);
+        int p = recv_source[done];
+        if (--chunks_left[p] == 0) push_run(stack, &top, recv + recv_displs[p], recv_counts[p]);
+    }
+
+    merge_run* list = calloc(top > 0 ? top : 1, sizeof(merge_run));
+    for (int i = 0; i < top; i++) list[i] = stack[i].run;
+    merge_run_list(list, top, dst);
+    for (int i = 0; i < top; i++) free(stack[i].owned);
+    MPI_Waitall(num_send, send_req, MPI_STATUSES_IGNORE);
+
+    free(list);
+    free(stack);
+    free(recv);
+    free(recv_req);
+    free(send_req);
+    free(recv_source);
+    free(chunks_left);
+}
+
+// quantas chaves do vetor ordenado são <= v
+static long long count_le(const dna_key* sorted, int n, key_u128 v) {
+    dna_key probe = dna_key_from_u128(v);
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (dna_key_cmp(&sorted[mid], &probe) <= 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// resultado de uma sonda v: quantas chaves são <= v e a maior delas (0 se
+// nenhuma; toda chave tem comprimento >= 1, então nunca vale 0)
+typedef struct {
+    long long count;
+    key_u128 last;
+} probe_result;
+
+// MPI_Op das sondas: soma as contagens e fica com a maior chave
+static void reduce_probe_results(void* in, void* inout, int* len, MPI_Datatype* type) {
+    (void)type;
+    const probe_result* a = in;
+    probe_result* b = inout;
+    for (int i = 0; i < *len; i++) {
+        b[i].count += a[i].count;
+        if (a[i].last > b[i].last) b[i].last = a[i].last;
+    }
+}
+
+// Separadores por histograma, sobre as chaves vistas como inteiros de 128
+// bits: o separador i procura um valor v com #{chaves <= v} perto do alvo
+// (i+1)·N/p (v não precisa ser uma chave existente). Cada um guarda um
+// intervalo [lo, hi] com as contagens globais das pontas; a cada rodada são
+// testadas `oversampling` sondas igualmente espaçadas dentro dele, contadas
+// na arena local (busca binária) e somadas por um único MPI_Allreduce, que
+// também devolve a maior chave <= cada sonda: hi desce até ela, então hi é
+// sempre uma chave existente. Para quando todo separador estiver a no máximo
+// tolerance/2 · N/p do alvo (então todo balde fica dentro de tolerance · N/p)
+// ou quando o intervalo aberto (lo, hi) não tiver mais nenhuma chave. Isso
+// acontece quando o alvo cai dentro das cópias de uma chave repetida: nenhuma
+// ponta chega perto do alvo e, sem essa saída, o intervalo seria bissectado
+// até largura 1 (até 128 rodadas). Para detectar, cada separador pendente
+// também sonda hi - 1; se a contagem for igual à de lo, o separador empatado
+// sai já e fica com hi, cujas cópias o split_ties reparte
+// Retorna o número de rodadas
+int histogram_splitters(const dna_key* sorted, int n, dna_key* global_splitters,
+                        const splitter_options* opts, MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+    int k = size - 1;
+    if (k == 0) return 0;
+    int s = opts->oversampling;
+
+    long long local_n = n, total;
+    MPI_Allreduce(&local_n, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+    // menor e maior chave: cada rank contribui com as pontas da sua arena
+    dna_key ends[2] = {{{UINT64_MAX, UINT64_MAX}}, {{0, 0}}};
+    if (n > 0) {
+        ends[0] = sorted[0];
+        ends[1] = sorted[n - 1];
+    }
+    dna_key* all_ends = malloc(2 * size * sizeof(dna_key));
+    MPI_Allgather(ends, 2 * sizeof(dna_key), MPI_BYTE, all_ends, 2 * sizeof(dna_key), MPI_BYTE,
+                  comm);
+    key_u128 min_key = dna_key_to_u128(&all_ends[0]), max_key = dna_key_to_u128(&all_ends[1]);
+    for (int p = 1; p < size; p++) {
+        key_u128 first = dna_key_to_u128(&all_ends[2 * p]);
+        key_u128 last = dna_key_to_u128(&all_ends[2 * p + 1]);
+        if (first < min_key) min_key = first;
+        if (last > max_key) max_key = last;
+    }
+    free(all_ends);
+
+    key_u128* lo = malloc(k * sizeof(key_u128));
+    key_u128* hi = malloc(k * sizeof(key_u128));
+    long long* lo_count = malloc(k * sizeof(long long));
+    long long* hi_count = malloc(k * sizeof(long long));
+    // s sondas espaçadas e, por último, hi - 1 (teste de empate)
+    int per = s + 1;
+    key_u128* probe = malloc(k * per * sizeof(key_u128));
+    probe_result* local_result = malloc(k * per * sizeof(probe_result));
+    probe_result* result = malloc(k * per * sizeof(probe_result));
+    int* tied = calloc(k, sizeof(int));
+    MPI_Datatype result_type;
+    MPI_Type_contiguous(sizeof(probe_result), MPI_BYTE, &result_type);
+    MPI_Type_commit(&result_type);
+    MPI_Op result_op;
+    MPI_Op_create(reduce_probe_results, 1, &result_op);
+    for (int i = 0; i < k; i++) {
+        // toda chave tem comprimento >= 1, então min_key >= 1
+        lo[i] = min_key - 1;
+        lo_count[i] = 0;
+        hi[i] = max_key;
+        hi_count[i] = total;
+    }
+    double slack = opts->tolerance / 2 * total / size;
+
+    int rounds = 0;
+    while (rounds < HISTOGRAM_MAX_ROUNDS) {
+        // todos os ranks têm os mesmos intervalos e decidem igual
+        int pending = 0;
+        for (int i = 0; i < k; i++) {
+            long long target = (i + 1) * total / size;
+            int done = target - lo_count[i] <= slack || hi_count[i] - target <= slack ||
+                       hi[i] - lo[i] <= 1 || tied[i];
+            key_u128 step = (hi[i] - lo[i]) / (s + 1);
+            if (step == 0) step = 1;
+            for (int j = 0; j < s; j++) {
+                key_u128 v = lo[i] + step * (j + 1);
+                probe[i * per + j] = done ? hi[i] : (v < hi[i] ? v : hi[i] - 1);
             }
-            free(temp_pack);
+            probe[i * per + s] = done ? hi[i] : hi[i] - 1;
+            pending += !done;
         }
+        if (!pending) break;
 
-        FILE* out = fopen("output.txt", "w");
-        for (int i = 0; i < total_n; i++) {
-            fprintf(out, "%s\n", sorted_global[i]);
+        for (int q = 0; q < k * per; q++) {
+            long long c = count_le(sorted, n, probe[q]);
+            local_result[q].count = c;
+            local_result[q].last = c > 0 ? dna_key_to_u128(&sorted[c - 1]) : 0;
         }
-        fclose(out);
-
-        printf("\nProcesso %d: Dados globais ordenados:\n", rank);
-        imprime(sorted_global, total_n, rank);
+        MPI_Allreduce(local_result, result, k * per, result_type, result_op, comm);
+        rounds++;
 
-        free_strings(sorted_global, total_n);
-        free(recv_counts);
-        free(recv_displs);
-    } else {
-        MPI_Send(&local_n, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);
-        char* pack = malloc(local_n * CHUNK_SIZE);
-        for (int j = 0; j < local_n; j++) {
-            memcpy(pack + j * CHUNK_SIZE, local_arr[j], CHUNK_SIZE);
+        for (int i = 0; i < k; i++) {
+            long long target = (i + 1) * total / size;
+            // nenhuma chave em (lo, hi): só as cópias de hi separam lo do alvo
+            if (result[i * per + s].count == lo_count[i]) tied[i] = 1;
+            for (int j = 0; j < per; j++) {
+                key_u128 v = probe[i * per + j];
+                long long c = result[i * per + j].count;
+                key_u128 last = result[i * per + j].last;
+                if (c <= target && v > lo[i]) {
+                    lo[i] = v;
+                    lo_count[i] = c;
+                }
+                // a maior chave <= v tem a mesma contagem
+                if (c >= target && v < hi[i]) {
+                    hi[i] = last > lo[i] ? last : v;
+                    hi_count[i] = c;
+                }
+            }
         }
-        MPI_Send(pack, local_n * CHUNK_SIZE, MPI_CHAR, 0, 2, MPI_COMM_WORLD);
-        free(pack);
     }
 
-    free_strings(local_arr, local_n);
-    MPI_Finalize();
-    return 0;
+    // fica com a ponta mais perto do alvo, mantendo os separadores em ordem;
+    // empatado ou intervalo sem divisão possível: o alvo cai dentro das
+    // cópias de hi, que o split_ties reparte, então fica com hi
+    key_u128 previous = 0;
+    for (int i = 0; i < k; i++) {
+        long long target = (i + 1) * total / size;
+        key_u128 v = !tied[i] && target - lo_count[i] <= hi_count[i] - target &&
+                             hi[i] - lo[i] > 1
+                         ? lo[i] : hi[i];
+        if (v < previous) v = previous;
+        global_splitters[i] = dna_key_from_u128(v);
+        previous = v;
+    }
+
+    free(lo);
+    free(hi);
+    free(lo_count);
+    free(hi_count);
+    free(probe);
+    free(local_result);
+    free(result);
+    free(tied);
+    MPI_Op_free(&result_op);
+    MPI_Type_free(&result_type);
+    return rounds;
 }
 
-void parallel_splitsort(char*** local_arr_ptr, int* local_n, MPI_Comm comm) {
+// Empates com os separadores. A regra "chave > separador" manda toda cópia
+// de um separador para o mesmo destino; com muitas leituras repetidas um
+// processo recebe quase tudo. Aqui as cópias do separador i são ordenadas por
+// (chave, processo de origem, posição) e cortadas no alvo (i+1)·N/p: a parte
+// até o alvo fica no balde i, o resto segue para os seguintes (separadores
+// repetidos dividem a mesma sequência). Se o alvo passa do fim das cópias,
+// nada muda em relação à regra antiga
+// cut[i] = posição local da primeira chave que vai para depois do balde i
+void split_ties(const dna_key* sorted, int n, const dna_key* splitters, int num_splitters,
+                int* cut, MPI_Comm comm) {
+    int k = num_splitters;
+    if (k == 0) return;
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+
+    // [lt_0, le_0, lt_1, le_1, ..., n]: contagens locais, depois globais
+    long long* local_count = malloc((2 * k + 1) * sizeof(long long));
+    long long* count = malloc((2 * k + 1) * sizeof(long long));
+    long long* local_eq = malloc(k * sizeof(long long));
+    long long* before = malloc(k * sizeof(long long));
+    for (int i = 0; i < k; i++) {
+        key_u128 v = dna_key_to_u128(&splitters[i]);
+        local_count[2 * i] = v > 0 ? count_le(sorted, n, v - 1) : 0;
+        local_count[2 * i + 1] = count_le(sorted, n, v);
+        local_eq[i] = local_count[2 * i + 1] - local_count[2 * i];
+    }
+    local_count[2 * k] = n;
+    MPI_Allreduce(local_count, count, 2 * k + 1, MPI_LONG_LONG, MPI_SUM, comm);
+    // cópias do separador i nos processos anteriores
+    MPI_Exscan(local_eq, before, k, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) {
+        for (int i = 0; i < k; i++) before[i] = 0;
+    }
+
+    long long total = count[2 * k];
+    for (int i = 0; i < k; i++) {
+        long long target = (i + 1) * total / size;
+        // quantas cópias, no total, ficam até o balde i
+        long long keep = target - count[2 * i];
+        if (keep < 0) keep = 0;
+        if (keep > count[2 * i + 1] - count[2 * i]) keep = count[2 * i + 1] - count[2 * i];
+        // quantas dessas são deste processo
+        keep -= before[i];
+        if (keep < 0) keep = 0;
+        if (keep > local_eq[i]) keep = local_eq[i];
+        cut[i] = local_count[2 * i] + keep;
+    }
+
+    free(local_count);
+    free(count);
+    free(local_eq);
+    free(before);
+}
+
+void parallel_splitsort(dna_arena* local, const splitter_options* opts, int exchange,
+                        MPI_Comm comm) {
     int rank, size;
     MPI_Comm_rank(comm, &rank);
     MPI_Comm_size(comm, &size);
 
-    if (*local_n == 0) return;
-
-    char** local_arr = *local_arr_ptr;
+    // ranks vazios (arquivos pequenos) ainda participam das coletivas
+    dna_key* local_arr = local->keys;
+    int local_n = local->count;
 
     // 1. Ordenação local
-    qsort(local_arr, *local_n, sizeof(char*), compare_dna);
+    int t = trace_begin("ordenacao_local");
+    qsort(local_arr, local_n, sizeof(dna_key), compare_dna);
+    trace_end(t, 0, 0);
     printf("Processo %d: Após ordenação local: ", rank);
-    imprime(local_arr, *local_n, rank);
+    imprime_keys(local_arr, local_n, rank);
 
-    // 2. Selecionar separadores locais
     int num_splitters = size - 1;
-    char local_splitters_flat[num_splitters * CHUNK_SIZE];
-    for (int i = 0; i < num_splitters; i++) {
-        int index = (i + 1) * (*local_n) / size;
-        if (index >= *local_n) index = *local_n - 1;
-        strcpy(local_splitters_flat + i * CHUNK_SIZE, local_arr[index]);
-    }
+    dna_key global_splitters[num_splitters];
+    dna_key* all_splitters = NULL;
 
-    // 3. Coletar separadores no processo 0
-    char* all_splitters_flat = NULL;
-    if (rank == 0) {
-        all_splitters_flat = malloc(size * num_splitters * CHUNK_SIZE);
-    }
-    MPI_Gather(local_splitters_flat, num_splitters * CHUNK_SIZE, MPI_CHAR,
-               all_splitters_flat, num_splitters * CHUNK_SIZE, MPI_CHAR, 0, comm);
+    if (opts->histogram) {
+        // 2-5. Separadores refinados por histograma global, sem processo 0
+        t = trace_begin("histograma");
+        int rounds = histogram_splitters(local_arr, local_n, global_splitters, opts, comm);
+        trace_end(t, 0, 0);
+        if (rank == 0) {
+            printf("Processo %d: Separadores por histograma (%d rodadas): ", rank, rounds);
+            imprime_keys(global_splitters, num_splitters, rank);
+        }
+    } else {
+        // 2. Selecionar separadores locais (oversampling por separador)
+        int num_samples = opts->oversampling * size - 1;
+        dna_key* local_splitters = malloc((num_samples > 0 ? num_samples : 1) * sizeof(dna_key));
+        for (int i = 0; i < num_samples; i++) {
+            int index = (long long)(i + 1) * local_n / (num_samples + 1);
+            if (index >= local_n) index = local_n - 1;
+            if (local_n == 0) {
+                // sem dados: amostra maior que qualquer chave
+                local_splitters[i].w[0] = local_splitters[i].w[1] = UINT64_MAX;
+            } else {
+                local_splitters[i] = local_arr[index];
+            }
+        }
 
-    // 4. Processo 0 seleciona separadores globais
-    char global_splitters_flat[num_splitters * CHUNK_SIZE];
-    if (rank == 0) {
-        int total_split = size * num_splitters;
-        int* indices = malloc(total_split * sizeof(int));
-        for (int ii = 0; ii < total_split; ii++) indices[ii] = ii;
+        // 3. Coletar separadores no processo 0
+        int total_split = size * num_samples;
+        if (rank == 0) {
+            all_splitters = malloc((total_split > 0 ? total_split : 1) * sizeof(dna_key));
+        }
+        t = trace_begin("coleta_amostras");
+        MPI_Gather(local_splitters, num_samples * sizeof(dna_key), MPI_BYTE,
+                   all_splitters, num_samples * sizeof(dna_key), MPI_BYTE, 0, comm);
+        trace_end(t, (long long)num_samples * sizeof(dna_key),
+                  rank == 0 ? (long long)total_split * sizeof(dna_key) : 0);
+        free(local_splitters);
 
-        current_flat = all_splitters_flat;
-        qsort(indices, total_split, sizeof(int), my_splitter_compare);
+        // 4. Processo 0 seleciona separadores globais
+        if (rank == 0) {
+            t = trace_begin("escolha_separadores");
+            qsort(all_splitters, total_split, sizeof(dna_key), compare_dna);
 
-        for (int i = 0; i < num_splitters; i++) {
-            int index = (i + 1) * total_split / size;
-            if (index >= total_split) index = total_split - 1;
-            strcpy(global_splitters_flat + i * CHUNK_SIZE, all_splitters_flat + indices[index] * CHUNK_SIZE);
-        }
-        free(indices);
+            for (int i = 0; i < num_splitters; i++) {
+                int index = (i + 1) * total_split / size;
+                if (index >= total_split) index = total_split - 1;
+                global_splitters[i] = all_splitters[index];
+            }
+            trace_end(t, 0, 0);
 
-        printf("Processo %d: Separadores globais: ", rank);
-        for (int i = 0; i < num_splitters; i++) {
-            printf("\"%s\" ", global_splitters_flat + i * CHUNK_SIZE);
+            printf("Processo %d: Separadores globais: ", rank);
+            imprime_keys(global_splitters, num_splitters, rank);
         }
-        printf("\n");
-    }
 
-    // 5. Broadcast dos separadores globais
-    MPI_Bcast(global_splitters_flat, num_splitters * CHUNK_SIZE, MPI_CHAR, 0, comm);
+        // 5. Broadcast dos separadores globais
+        t = trace_begin("bcast_separadores");
+        MPI_Bcast(global_splitters, num_splitters * sizeof(dna_key), MPI_BYTE, 0, comm);
+        long long splitter_bytes = num_splitters * sizeof(dna_key);
+        trace_end(t, rank == 0 ? splitter_bytes : 0, rank == 0 ? 0 : splitter_bytes);
+    }
 
     // 6. Redistribuição
+    // A arena já está ordenada, então cada destino é uma faixa contígua dela
+    // e o Alltoallv envia direto da arena, sem buffer de envio; basta contar
+    // quantos registros vão para cada destino, pela árvore de separadores
+    t = trace_begin("classificacao");
+    splitter_tree st;
+    build_splitter_tree(&st, global_splitters, num_splitters);
     int* send_counts = calloc(size, sizeof(int));
-    for (int i = 0; i < *local_n; i++) {
-        char* element = local_arr[i];
-        int target = 0;
-        while (target < num_splitters && strcmp(element, global_splitters_flat + target * CHUNK_SIZE) > 0) {
-            target++;
-        }
-        send_counts[target]++;
+    classify_keys(&st, local_arr, local_n, send_counts);
+    free(st.tree);
+    trace_end(t, 0, 0);
+
+    // cópias de um separador além do corte seguem para o balde seguinte;
+    // a faixa do balde i termina no corte i em vez de depois da última cópia
+    t = trace_begin("empates");
+    int* cut = malloc((num_splitters > 0 ? num_splitters : 1) * sizeof(int));
+    split_ties(local_arr, local_n, global_splitters, num_splitters, cut, comm);
+    int end = 0;
+    for (int i = 0; i < num_splitters; i++) {
+        end += send_counts[i];
+        send_counts[i + 1] += end - cut[i];
+        send_counts[i] -= end - cut[i];
+        end = cut[i];
     }
+    free(cut);
+    trace_end(t, 0, 0);
 
+    t = trace_begin("troca_contagens");
     int* recv_counts = malloc(size * sizeof(int));
     MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+    trace_end(t, (size - 1) * sizeof(int), (size - 1) * sizeof(int));
 
     int* send_displs = malloc(size * sizeof(int));
     int* recv_displs = malloc(size * sizeof(int));
@@ -257,63 +1443,64 @@ void parallel_splitsort(char*** local_arr_ptr, int* local_n, MPI_Comm comm) {
     }
 
     int total_recv = recv_displs[size - 1] + recv_counts[size - 1];
+    // bytes que saem e chegam pela rede (a faixa do próprio rank não conta)
+    long long bytes_sent = (long long)(local_n - send_counts[rank]) * sizeof(dna_key);
+    long long bytes_received = (long long)(total_recv - recv_counts[rank]) * sizeof(dna_key);
 
-    int* send_counts_char = malloc(size * sizeof(int));
-    int* recv_counts_char = malloc(size * sizeof(int));
-    int* send_displs_char = malloc(size * sizeof(int));
-    int* recv_displs_char = malloc(size * sizeof(int));
-    for (int i = 0; i < size; i++) {
-        send_counts_char[i] = send_counts[i] * CHUNK_SIZE;
-        recv_counts_char[i] = recv_counts[i] * CHUNK_SIZE;
-    }
-    send_displs_char[0] = recv_displs_char[0] = 0;
-    for (int i = 1; i < size; i++) {
-        send_displs_char[i] = send_displs_char[i - 1] + send_counts_char[i - 1];
-        recv_displs_char[i] = recv_displs_char[i - 1] + recv_counts_char[i - 1];
+    // Desbalanceamento: maior balde em relação à média n/p
+    long long my_recv = total_recv, max_recv, total;
+    MPI_Allreduce(&my_recv, &max_recv, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    MPI_Allreduce(&my_recv, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0 && total > 0) {
+        printf("Processo %d: Desbalanceamento: maior balde %lld, media %.1f (%.3fx)\n",
+               rank, max_recv, (double)total / size, max_recv * (double)size / total);
     }
 
-    char* send_buffer = malloc(send_displs_char[size - 1] + send_counts_char[size - 1]);
-    int* temp_counts = calloc(size, sizeof(int));
-    for (int i = 0; i < *local_n; i++) {
-        char* element = local_arr[i];
-        int target = 0;
-        while (target < num_splitters && strcmp(element, global_splitters_flat + target * CHUNK_SIZE) > 0) {
-            target++;
+    dna_arena merged;
+    arena_init(&merged, total_recv);
+    if (exchange == EXCHANGE_PIPELINE) {
+        // 6-7. Envio em pedaços, intercalando as faixas conforme chegam
+        t = trace_begin("troca_e_intercalacao");
+        exchange_and_merge(local_arr, send_counts, send_displs, recv_counts, recv_displs,
+                           merged.keys, comm);
+        trace_end(t, bytes_sent, bytes_received);
+    } else {
+        // contagens e deslocamentos em bytes, reaproveitando os vetores
+        for (int i = 0; i < size; i++) {
+            send_counts[i] *= sizeof(dna_key);
+            recv_counts[i] *= sizeof(dna_key);
+            send_displs[i] *= sizeof(dna_key);
+            recv_displs[i] *= sizeof(dna_key);
         }
-        int pos = temp_counts[target] * CHUNK_SIZE;  // Pos relativo no buffer de target
-        memcpy(send_buffer + send_displs_char[target] + pos, element, CHUNK_SIZE);
-        temp_counts[target]++;
-    }
 
-    char* recv_buffer = malloc(total_recv * CHUNK_SIZE);
-    MPI_Alltoallv(send_buffer, send_counts_char, send_displs_char, MPI_CHAR,
-                  recv_buffer, recv_counts_char, recv_displs_char, MPI_CHAR, comm);
+        dna_arena received;
+        arena_init(&received, total_recv);
+        t = trace_begin("troca_dados");
+        MPI_Alltoallv(local_arr, send_counts, send_displs, MPI_BYTE,
+                      received.keys, recv_counts, recv_displs, MPI_BYTE, comm);
+        received.count = total_recv;
+        trace_end(t, bytes_sent, bytes_received);
 
-    char** new_local_arr = malloc(total_recv * sizeof(char*));
-    for (int i = 0; i < total_recv; i++) {
-        new_local_arr[i] = malloc(CHUNK_SIZE);
-        memcpy(new_local_arr[i], recv_buffer + i * CHUNK_SIZE, CHUNK_SIZE);
+        // 7. Intercalação final: cada processo mandou uma faixa já ordenada,
+        // então basta intercalar as size faixas em vez de reordenar tudo
+        for (int i = 0; i < size; i++) {
+            recv_counts[i] /= sizeof(dna_key);
+            recv_displs[i] /= sizeof(dna_key);
+        }
+        t = trace_begin("intercalacao");
+        merge_runs(received.keys, recv_counts, recv_displs, size, merged.keys);
+        trace_end(t, 0, 0);
+        arena_free(&received);
     }
-    free(recv_buffer);
-
-    free_strings(local_arr, *local_n);
-    *local_arr_ptr = new_local_arr;
-    *local_n = total_recv;
-
-    // 7. Ordenação final
-    qsort(new_local_arr, *local_n, sizeof(char*), compare_dna);
+    merged.count = total_recv;
+    arena_swap(local, &merged);
+    arena_free(&merged);
     printf("Processo %d: Após redistribuição e sort final: ", rank);
-    imprime(new_local_arr, *local_n, rank);
+    imprime_keys(local->keys, local->count, rank);
 
-    free(all_splitters_flat);
+    free(all_splitters);
     free(send_counts);
     free(recv_counts);
     free(send_displs);
     free(recv_displs);
-    free(send_counts_char);
-    free(recv_counts_char);
-    free(send_displs_char);
-    free(recv_displs_char);
-    free(send_buffer);
-    free(temp_counts);
-}
\ No newline at end of file
+}
@@ -1,10 +1,55 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 #define MAX_SEQ_LENGTH 1000000
 #define DNA_CHARS "ACGT"
+// 32 bases na palavra 0 + 28 na palavra 1; os 8 bits finais guardam o comprimento
+#define DNA_KEY_MAX_BASES 60
+// baldes menores que isso vao para o insertion sort no radix
+#define RADIX_INSERTION_THRESHOLD 32
+// trechos menores que isso vao para o insertion sort no merge sort com LCP
+#define LCP_INSERTION_THRESHOLD 16
+// a chave tem 16 bytes; cada digito do radix e 1 byte (4 bases)
+#define RADIX_DIGITS 16
+
+enum sort_mode { MODE_QSORT, MODE_RADIX, MODE_CHECK };
+enum input_mode { INPUT_FGETS, INPUT_MMAP };
+enum file_format { FORMAT_TEXT, FORMAT_BINARY };
+
+// sequencia empacotada com 2 bits por base (A=0, C=1, G=2, T=3)
+// a comparacao de (w[0], w[1]) como inteiros sem sinal equivale ao strcmp
+typedef struct {
+  uint64_t w[2];
+} dna_key;
+
+// Arquivo binario: cabecalho de 32 bytes e depois os registros, cada um um
+// dna_key de 16 bytes como fica na memoria (w[0], w[1], little-endian).
+// O registro i comeca em sizeof(dna_bin_header) + i * sizeof(dna_key) e a
+// leitura cai direto no vetor de chaves, sem conversao
+#define DNA_BIN_MAGIC "DNA2BIT"
+#define DNA_BIN_VERSION 1
+#define DNA_BIN_ENCODING_2BIT 1
+
+typedef struct {
+  char magic[8];        // "DNA2BIT\0"
+  uint32_t version;     // DNA_BIN_VERSION
+  uint32_t encoding;    // DNA_BIN_ENCODING_2BIT
+  uint64_t count;       // numero de registros
+  uint32_t seq_length;  // comprimento comum das sequencias, 0 se variar
+  uint32_t record_size; // sizeof(dna_key)
+} dna_bin_header;
+
+// linha do arquivo mapeado: aponta para o mapeamento, sem copia e sem '\0'
+typedef struct {
+  const char *seq;
+  int len;
+} dna_view;
 
 // gera sequencias de modo aleatorio
 void generate_dna_sequence(char *seq, int length) {
@@ -19,16 +64,410 @@ int compare_dna(const void *a, const void *b) {
   return strcmp(*(const char **)a, *(const char **)b);
 }
 
-// realiza a ordenacao usando o qsort sequencial
-void sequential_sort(char **data, int n) {
-  qsort(data, n, sizeof(char *), compare_dna);
+// codigo de 2 bits da base, ou -1 se nao for A/C/G/T
+static inline int dna_base_code(char c) {
+  switch (c) {
+  case 'A':
+    return 0;
+  case 'C':
+    return 1;
+  case 'G':
+    return 2;
+  case 'T':
+    return 3;
+  }
+  return -1;
+}
+
+// empacota os len primeiros caracteres; retorna 0 se nao couberem na chave
+int dna_pack_n(const char *seq, int len, dna_key *key) {
+  key->w[0] = key->w[1] = 0;
+  if (len > DNA_KEY_MAX_BASES)
+    return 0;
+  for (int i = 0; i < len; i++) {
+    int code = dna_base_code(seq[i]);
+    if (code < 0)
+      return 0;
+    key->w[i / 32] |= (uint64_t)code << (62 - 2 * (i % 32));
+  }
+  key->w[1] |= (uint64_t)len;
+  return 1;
+}
+
+// empacota a sequencia; retorna 0 se ela nao couber na chave
+int dna_pack(const char *seq, dna_key *key) {
+  return dna_pack_n(seq, (int)strlen(seq), key);
+}
+
+// desempacota a chave para texto (seq precisa de DNA_KEY_MAX_BASES + 1)
+void dna_unpack(const dna_key *key, char *seq) {
+  int len = (int)(key->w[1] & 0xFF);
+  if (len > DNA_KEY_MAX_BASES)
+    len = DNA_KEY_MAX_BASES;
+  for (int i = 0; i < len; i++) {
+    seq[i] = DNA_CHARS[(key->w[i / 32] >> (62 - 2 * (i % 32))) & 3];
+  }
+  seq[len] = '\0';
+}
+
+// cabecalho do arquivo binario com count registros de comprimento length
+void dna_bin_header_init(dna_bin_header *h, uint64_t count, uint32_t length) {
+  memset(h, 0, sizeof(*h));
+  memcpy(h->magic, DNA_BIN_MAGIC, sizeof(DNA_BIN_MAGIC));
+  h->version = DNA_BIN_VERSION;
+  h->encoding = DNA_BIN_ENCODING_2BIT;
+  h->count = count;
+  h->seq_length = length;
+  h->record_size = sizeof(dna_key);
+}
+
+int dna_bin_header_valid(const dna_bin_header *h) {
+  return memcmp(h->magic, DNA_BIN_MAGIC, sizeof(DNA_BIN_MAGIC)) == 0 &&
+         h->version == DNA_BIN_VERSION &&
+         h->encoding == DNA_BIN_ENCODING_2BIT &&
+         h->record_size == sizeof(dna_key);
+}
+
+// comprimento comum das chaves, ou 0 se variar (campo seq_length)
+uint32_t dna_common_length(const dna_key *keys, int n) {
+  if (n <= 0)
+    return 0;
+  uint64_t length = keys[0].w[1] & 0xFF;
+  for (int i = 1; i < n; i++) {
+    if ((keys[i].w[1] & 0xFF) != length)
+      return 0;
+  }
+  return (uint32_t)length;
+}
+
+static inline int dna_key_cmp(const dna_key *a, const dna_key *b) {
+  if (a->w[0] != b->w[0])
+    return a->w[0] < b->w[0] ? -1 : 1;
+  if (a->w[1] != b->w[1])
+    return a->w[1] < b->w[1] ? -1 : 1;
+  return 0;
+}
+
+int compare_dna_key(const void *a, const void *b) {
+  return dna_key_cmp((const dna_key *)a, (const dna_key *)b);
+}
+
+// mesma ordem do strcmp, mas sobre linhas sem terminador
+int compare_dna_view(const void *a, const void *b) {
+  const dna_view *va = (const dna_view *)a;
+  const dna_view *vb = (const dna_view *)b;
+  int c = memcmp(va->seq, vb->seq, va->len < vb->len ? va->len : vb->len);
+  if (c != 0)
+    return c;
+  return (va->len > vb->len) - (va->len < vb->len);
+}
+
+// empacota todas as sequencias; NULL se alguma nao for ACGT puro ou se os
+// comprimentos variarem (a decodificacao reescreve as strings no lugar)
+dna_key *pack_all(char **data, int n) {
+  dna_key *keys = (dna_key *)malloc(n * sizeof(dna_key));
+  if (!keys)
+    return NULL;
+  size_t length = strlen(data[0]);
+  for (int i = 0; i < n; i++) {
+    if (strlen(data[i]) != length || !dna_pack(data[i], &keys[i])) {
+      free(keys);
+      return NULL;
+    }
+  }
+  return keys;
+}
+
+// versao de pack_all para as linhas do arquivo mapeado
+dna_key *pack_views(const dna_view *views, int n) {
+  dna_key *keys = (dna_key *)malloc(n * sizeof(dna_key));
+  if (!keys)
+    return NULL;
+  for (int i = 0; i < n; i++) {
+    if (views[i].len != views[0].len ||
+        !dna_pack_n(views[i].seq, views[i].len, &keys[i])) {
+      free(keys);
+      return NULL;
+    }
+  }
+  return keys;
+}
+
+// byte d da chave, do mais significativo para o menos
+static inline int key_digit(const dna_key *key, int d) {
+  return (int)((key->w[d / 8] >> (56 - 8 * (d % 8))) & 0xFF);
+}
+
+void insertion_sort_keys(dna_key *keys, int n) {
+  for (int i = 1; i < n; i++) {
+    dna_key key = keys[i];
+    int j = i - 1;
+    while (j >= 0 && dna_key_cmp(&keys[j], &key) > 0) {
+      keys[j + 1] = keys[j];
+      j--;
+    }
+    keys[j + 1] = key;
+  }
+}
+
+// radix MSD sobre as chaves empacotadas, 4 bases (8 bits) por passada
+// aux precisa ter espaco para n chaves
+void radix_sort_keys(dna_key *keys, dna_key *aux, int n, int digit) {
+  while (digit < RADIX_DIGITS) {
+    if (n < RADIX_INSERTION_THRESHOLD) {
+      insertion_sort_keys(keys, n);
+      return;
+    }
+
+    int count[256] = {0};
+    for (int i = 0; i < n; i++)
+      count[key_digit(&keys[i], digit)]++;
+
+    // todos no mesmo balde: passa direto para o proximo digito
+    if (count[key_digit(&keys[0], digit)] == n) {
+      digit++;
+      continue;
+    }
+
+    int start[256];
+    start[0] = 0;
+    for (int b = 1; b < 256; b++)
+      start[b] = start[b - 1] + count[b - 1];
+
+    int pos[256];
+    memcpy(pos, start, sizeof(pos));
+    for (int i = 0; i < n; i++)
+      aux[pos[key_digit(&keys[i], digit)]++] = keys[i];
+    memcpy(keys, aux, n * sizeof(dna_key));
+
+    for (int b = 0; b < 256; b++) {
+      if (count[b] > 1)
+        radix_sort_keys(keys + start[b], aux + start[b], count[b], digit + 1);
+    }
+    return;
+  }
+}
+
+// Merge sort com LCP para as linhas que nao cabem na chave (comprimentos
+// acima de DNA_KEY_MAX_BASES ou letras fora de ACGT). Cada trecho ordenado
+// leva junto lcp[i] = prefixo comum de views[i - 1] e views[i]; na
+// intercalacao, h_a e h_b guardam o prefixo comum de cada cabeca com a
+// ultima linha emitida. Se forem diferentes, a cabeca de h maior e a menor
+// sem olhar nenhum caractere; se forem iguais, a comparacao comeca em h e
+// nao no caractere 0. Leituras com prefixos longos em comum deixam de ser
+// relidas do inicio a cada comparacao
+
+// compara a partir do caractere h (os h primeiros ja sao iguais) e devolve
+// em *lcp o prefixo comum
+static inline int compare_view_from(const dna_view *a, const dna_view *b, int h,
+                                    int *lcp) {
+  int m = a->len < b->len ? a->len : b->len;
+  // 8 caracteres por vez; o primeiro byte diferente sai do xor (little-endian)
+  while (h + 8 <= m) {
+    uint64_t x, y;
+    memcpy(&x, a->seq + h, 8);
+    memcpy(&y, b->seq + h, 8);
+    if (x != y) {
+      h += __builtin_ctzll(x ^ y) / 8;
+      break;
+    }
+    h += 8;
+  }
+  while (h < m && a->seq[h] == b->seq[h])
+    h++;
+  *lcp = h;
+  if (h < m)
+    return (unsigned char)a->seq[h] - (unsigned char)b->seq[h];
+  return (a->len > b->len) - (a->len < b->len);
+}
+
+// intercala a[0..na) e b[0..nb), com os seus lcp, em out/out_lcp
+static void lcp_merge(const dna_view *a, const int *a_lcp, int na,
+                      const dna_view *b, const int *b_lcp, int nb,
+                      dna_view *out, int *out_lcp) {
+  int i = 0, j = 0, k = 0;
+  int ha = 0, hb = 0;
+  while (i < na && j < nb) {
+    int take_a;
+    if (ha != hb) {
+      take_a = ha > hb;
+    } else {
+      int h;
+      take_a = compare_view_from(&a[i], &b[j], ha, &h) <= 0;
+      // a cabeca que fica compartilha h caracteres com a que sai
+      if (take_a)
+        hb = h;
+      else
+        ha = h;
+    }
+    if (take_a) {
+      out_lcp[k] = ha;
+      out[k++] = a[i++];
+      ha = i < na ? a_lcp[i] : 0;
+    } else {
+      out_lcp[k] = hb;
+      out[k++] = b[j++];
+      hb = j < nb ? b_lcp[j] : 0;
+    }
+  }
+  // o primeiro do que sobra herda o h da cabeca; os outros, o proprio lcp
+  for (int first = 1; i < na; i++, first = 0) {
+    out_lcp[k] = first ? ha : a_lcp[i];
+    out[k++] = a[i];
+  }
+  for (int first = 1; j < nb; j++, first = 0) {
+    out_lcp[k] = first ? hb : b_lcp[j];
+    out[k++] = b[j];
+  }
+}
+
+// ordena views[0..n) e preenche lcp; aux e aux_lcp sao areas de n posicoes
+static void lcp_merge_sort(dna_view *views, int *lcp, dna_view *aux,
+                           int *aux_lcp, int n) {
+  if (n < LCP_INSERTION_THRESHOLD) {
+    for (int i = 1; i < n; i++) {
+      dna_view v = views[i];
+      int j = i - 1, h;
+      while (j >= 0 && compare_view_from(&views[j], &v, 0, &h) > 0) {
+        views[j + 1] = views[j];
+        j--;
+      }
+      views[j + 1] = v;
+    }
+    if (n > 0)
+      lcp[0] = 0;
+    for (int i = 1; i < n; i++)
+      compare_view_from(&views[i - 1], &views[i], 0, &lcp[i]);
+    return;
+  }
+  int half = n / 2;
+  lcp_merge_sort(views, lcp, aux, aux_lcp, half);
+  lcp_merge_sort(views + half, lcp + half, aux, aux_lcp, n - half);
+  lcp_merge(views, lcp, half, views + half, lcp + half, n - half, aux, aux_lcp);
+  memcpy(views, aux, n * sizeof(dna_view));
+  memcpy(lcp, aux_lcp, n * sizeof(int));
+}
+
+// ordena as linhas com o merge sort com LCP; no modo check confere com o
+// qsort sobre as mesmas linhas. Retorna 0 se a conferencia falhar
+int sort_views_lcp(dna_view *views, int n, int mode) {
+  dna_view *reference = NULL;
+  if (mode == MODE_CHECK) {
+    reference = (dna_view *)malloc(n * sizeof(dna_view));
+    memcpy(reference, views, n * sizeof(dna_view));
+    qsort(reference, n, sizeof(dna_view), compare_dna_view);
+  }
+  dna_view *aux = (dna_view *)malloc(n * sizeof(dna_view));
+  int *lcp = (int *)malloc(2 * (size_t)n * sizeof(int));
+  lcp_merge_sort(views, lcp, aux, lcp + n, n);
+  free(lcp);
+  free(aux);
+
+  int ok = 1;
+  if (reference) {
+    for (int i = 0; i < n && ok; i++)
+      ok = compare_dna_view(&views[i], &reference[i]) == 0;
+    printf("Conferencia LCP x qsort: %s\n", ok ? "OK" : "DIVERGENTE");
+    free(reference);
+  }
+  return ok;
+}
+
+// ordena as chaves empacotadas com o qsort ou com o radix
+// no modo check roda os dois e confere se o radix bate com o qsort
+// retorna 0 se a conferencia falhar
+int sort_keys(dna_key *keys, int n, int mode) {
+  if (mode == MODE_QSORT) {
+    qsort(keys, n, sizeof(dna_key), compare_dna_key);
+    return 1;
+  }
+
+  int ok = 1;
+  dna_key *aux = (dna_key *)malloc(n * sizeof(dna_key));
+  dna_key *reference = NULL;
+  if (mode == MODE_CHECK) {
+    reference = (dna_key *)malloc(n * sizeof(dna_key));
+    memcpy(reference, keys, n * sizeof(dna_key));
+    qsort(reference, n, sizeof(dna_key), compare_dna_key);
+  }
+  radix_sort_keys(keys, aux, n, 0);
+  if (reference) {
+    ok = memcmp(keys, reference, n * sizeof(dna_key)) == 0;
+    printf("Conferencia radix x qsort: %s\n", ok ? "OK" : "DIVERGENTE");
+    free(reference);
+  }
+  free(aux);
+  return ok;
+}
+
+// realiza a ordenacao sequencial (qsort ou radix)
+// com sequencias ACGT de mesmo tamanho ordena as chaves empacotadas e so
+// decodifica no fim; caso contrario cai no strcmp (qsort) ou no merge sort
+// com LCP (radix e check) sobre as strings
+// retorna 0 se a conferencia do modo check falhar
+int sequential_sort(char **data, int n, int mode) {
+  if (n <= 0)
+    return 1;
+  dna_key *keys = pack_all(data, n);
+  if (!keys && mode == MODE_QSORT) {
+    qsort(data, n, sizeof(char *), compare_dna);
+    return 1;
+  }
+  if (!keys) {
+    // as strings viram views (sem copia) para o merge sort com LCP
+    printf("Entrada nao empacotavel, usando merge sort com LCP\n");
+    dna_view *views = (dna_view *)malloc(n * sizeof(dna_view));
+    for (int i = 0; i < n; i++) {
+      views[i].seq = data[i];
+      views[i].len = (int)strlen(data[i]);
+    }
+    int ok = sort_views_lcp(views, n, mode);
+    for (int i = 0; i < n; i++)
+      data[i] = (char *)views[i].seq;
+    free(views);
+    return ok;
+  }
+
+  int ok = sort_keys(keys, n, mode);
+  for (int i = 0; i < n; i++)
+    dna_unpack(&keys[i], data[i]);
+  free(keys);
+  return ok;
+}
+
+// ordenacao sobre as linhas do arquivo mapeado
+// o mapeamento e somente leitura: se a entrada for empacotavel o resultado
+// fica em *sorted_keys (decodificado so na escrita); senao as proprias views
+// sao ordenadas e *sorted_keys fica NULL
+int sequential_sort_views(dna_view *views, int n, int mode,
+                          dna_key **sorted_keys) {
+  *sorted_keys = NULL;
+  if (n <= 0)
+    return 1;
+  dna_key *keys = pack_views(views, n);
+  if (!keys && mode == MODE_QSORT) {
+    qsort(views, n, sizeof(dna_view), compare_dna_view);
+    return 1;
+  }
+  if (!keys) {
+    printf("Entrada nao empacotavel, usando merge sort com LCP\n");
+    return sort_views_lcp(views, n, mode);
+  }
+
+  *sorted_keys = keys;
+  return sort_keys(keys, n, mode);
+}
+
+// tempo de parede em segundos (clock() mede CPU, nao o tempo decorrido)
+double wall_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
 }
 
-// função para salvar os resultados no arquivo
+// função para salvar os resultados no arquivo (no diretorio atual)
 void save_results_to_file(int n, int length, double time_taken) {
-  FILE *file = fopen(
-      "/home/jhonathan/T1_ProgP/for_DNAsequences/resultados_ordenacao.txt",
-      "a");
+  FILE *file = fopen("resultados_ordenacao.txt", "a");
   if (file == NULL) {
     printf("erro ao abrir o arquivo para salvar resultados!\n");
     return;
@@ -79,6 +518,152 @@ char **read_dna_file(const char *filename, int *total_seqs) {
   return sequences;
 }
 
+// Leitura via mmap: o arquivo e mapeado e as linhas viram views para dentro
+// do mapeamento, sem malloc nem copia por linha. As quebras de linha sao
+// achadas com memchr, que na glibc e vetorizado (SSE2/AVX2)
+dna_view *map_dna_file(const char *filename, int *total_seqs, void **map,
+                       size_t *map_size) {
+  FILE *file = fopen(filename, "r");
+  if (!file) {
+    perror("Erro ao abrir arquivo");
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fileno(file), &st) != 0) {
+    perror("Erro ao ler tamanho do arquivo");
+    fclose(file);
+    return NULL;
+  }
+
+  size_t size = (size_t)st.st_size;
+  const char *data = NULL;
+  if (size > 0) {
+    data = (const char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE,
+                              fileno(file), 0);
+    if (data == MAP_FAILED) {
+      perror("Erro ao mapear arquivo");
+      fclose(file);
+      return NULL;
+    }
+    madvise((void *)data, size, MADV_SEQUENTIAL);
+  }
+  // o mapeamento continua valido depois do fclose
+  fclose(file);
+
+  // estimativa pelo tamanho da primeira linha: exata para comprimento fixo
+  const char *end = data + size;
+  const char *nl = size > 0 ? (const char *)memchr(data, '\n', size) : NULL;
+  size_t first_line = nl ? (size_t)(nl - data) + 1 : size;
+  size_t capacity = first_line > 0 ? size / first_line + 1 : 1;
+  int count = 0;
+
+  dna_view *views = (dna_view *)malloc(capacity * sizeof(dna_view));
+  if (!views) {
+    if (data)
+      munmap((void *)data, size);
+    return NULL;
+  }
+
+  const char *line = data;
+  while (line < end) {
+    nl = (const char *)memchr(line, '\n', end - line);
+    const char *line_end = nl ? nl : end;
+    if ((size_t)count >= capacity) {
+      capacity *= 2;
+      dna_view *grown = (dna_view *)realloc(views, capacity * sizeof(dna_view));
+      if (!grown) {
+        free(views);
+        munmap((void *)data, size);
+        return NULL;
+      }
+      views = grown;
+    }
+    views[count].seq = line;
+    views[count].len = (int)(line_end - line);
+    count++;
+    line = line_end + 1;
+  }
+
+  *map = (void *)data;
+  *map_size = size;
+  *total_seqs = count;
+  return views;
+}
+
+// 1 se o arquivo comeca com o cabecalho do formato binario
+int is_dna_binary_file(const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  if (!file)
+    return 0;
+  dna_bin_header h;
+  int binary = fread(&h, sizeof(h), 1, file) == 1 && dna_bin_header_valid(&h);
+  fclose(file);
+  return binary;
+}
+
+// Leitura do formato binario: um fread do bloco de registros direto no
+// vetor de chaves, que ja sai pronto para o sort_keys
+dna_key *read_dna_binary(const char *filename, int *total_seqs, int *length) {
+  FILE *file = fopen(filename, "rb");
+  if (!file) {
+    perror("Erro ao abrir arquivo");
+    return NULL;
+  }
+  dna_bin_header h;
+  if (fread(&h, sizeof(h), 1, file) != 1 || !dna_bin_header_valid(&h) ||
+      h.count > (uint64_t)INT32_MAX) {
+    fprintf(stderr, "Cabecalho binario invalido em %s\n", filename);
+    fclose(file);
+    return NULL;
+  }
+  int n = (int)h.count;
+  dna_key *keys = (dna_key *)malloc((n > 0 ? n : 1) * sizeof(dna_key));
+  if (!keys || fread(keys, sizeof(dna_key), n, file) != (size_t)n) {
+    fprintf(stderr, "Arquivo binario truncado: %s\n", filename);
+    free(keys);
+    fclose(file);
+    return NULL;
+  }
+  fclose(file);
+  *total_seqs = n;
+  *length = (int)h.seq_length;
+  return keys;
+}
+
+// Escrita do formato binario: cabecalho e as chaves como estao na memoria
+void write_dna_binary(const char *filename, const dna_key *keys,
+                      int total_seqs) {
+  FILE *file = fopen(filename, "wb");
+  if (!file) {
+    perror("Erro ao criar arquivo de saída");
+    return;
+  }
+  dna_bin_header h;
+  dna_bin_header_init(&h, total_seqs, dna_common_length(keys, total_seqs));
+  if (fwrite(&h, sizeof(h), 1, file) != 1 ||
+      fwrite(keys, sizeof(dna_key), total_seqs, file) != (size_t)total_seqs)
+    perror("Erro ao escrever arquivo de saída");
+  fclose(file);
+}
+
+// empacota a saida ordenada em texto para a escrita binaria; aceita
+// comprimentos variados, mas so sequencias ACGT de ate DNA_KEY_MAX_BASES
+dna_key *pack_for_binary(char **sequences, const dna_view *views, int n) {
+  dna_key *keys = (dna_key *)malloc((n > 0 ? n : 1) * sizeof(dna_key));
+  if (!keys)
+    return NULL;
+  for (int i = 0; i < n; i++) {
+    int ok = views ? dna_pack_n(views[i].seq, views[i].len, &keys[i])
+                   : dna_pack(sequences[i], &keys[i]);
+    if (!ok) {
+      fprintf(stderr, "Sequencia %d nao cabe no formato binario\n", i);
+      free(keys);
+      return NULL;
+    }
+  }
+  return keys;
+}
+
 void write_dna_file(const char *filename, char **sequences, int total_seqs) {
   FILE *file = fopen(filename, "w");
   if (!file) {
@@ -91,42 +676,142 @@ void write_dna_file(const char *filename, char **sequences, int total_seqs) {
   fclose(file);
 }
 
+// saida do modo mmap: chaves decodificadas ou views na ordem final
+void write_dna_result(const char *filename, const dna_key *keys,
+                      const dna_view *views, int total_seqs) {
+  FILE *file = fopen(filename, "w");
+  if (!file) {
+    perror("Erro ao criar arquivo de saída");
+    return;
+  }
+  char seq[DNA_KEY_MAX_BASES + 1];
+  for (int i = 0; i < total_seqs; i++) {
+    if (keys) {
+      dna_unpack(&keys[i], seq);
+      fprintf(file, "%s\n", seq);
+    } else {
+      fwrite(views[i].seq, 1, views[i].len, file);
+      fputc('\n', file);
+    }
+  }
+  fclose(file);
+}
+
+void print_usage(const char *prog) {
+  printf("Uso: %s [-m qsort|radix|check] [-i fgets|mmap] [-f texto|binario] "
+         "<arquivo_entrada> <arquivo_saida>\n",
+         prog);
+  printf("A entrada binaria e detectada pelo cabecalho; -f escolhe o formato "
+         "da saida\n");
+}
+
 int main(int argc, char *argv[]) {
-  if (argc != 3) {
-    printf("Uso: %s <arquivo_entrada> <arquivo_saida>\n", argv[0]);
+  int mode = MODE_QSORT;
+  int input = INPUT_FGETS;
+  int format = FORMAT_TEXT;
+  int opt;
+  while ((opt = getopt(argc, argv, "m:i:f:")) != -1) {
+    if (opt == 'm' && strcmp(optarg, "qsort") == 0) {
+      mode = MODE_QSORT;
+    } else if (opt == 'm' && strcmp(optarg, "radix") == 0) {
+      mode = MODE_RADIX;
+    } else if (opt == 'm' && strcmp(optarg, "check") == 0) {
+      mode = MODE_CHECK;
+    } else if (opt == 'i' && strcmp(optarg, "fgets") == 0) {
+      input = INPUT_FGETS;
+    } else if (opt == 'i' && strcmp(optarg, "mmap") == 0) {
+      input = INPUT_MMAP;
+    } else if (opt == 'f' && strcmp(optarg, "texto") == 0) {
+      format = FORMAT_TEXT;
+    } else if (opt == 'f' && strcmp(optarg, "binario") == 0) {
+      format = FORMAT_BINARY;
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (argc - optind != 2) {
+    print_usage(argv[0]);
     return 1;
   }
 
-  const char *input_file = argv[1];
-  const char *output_file = argv[2];
+  const char *input_file = argv[optind];
+  const char *output_file = argv[optind + 1];
 
   int n = 0;
-  char **sequences = read_dna_file(input_file, &n);
-  if (!sequences) {
-    return 1;
+  int length = 0;
+  dna_key *keys = NULL;
+  char **sequences = NULL;
+  dna_view *views = NULL;
+  void *map = NULL;
+  size_t map_size = 0;
+
+  double load_start = wall_time();
+  if (is_dna_binary_file(input_file)) {
+    // ja empacotado: -i nao se aplica
+    keys = read_dna_binary(input_file, &n, &length);
+    if (!keys)
+      return 1;
+  } else if (input == INPUT_MMAP) {
+    views = map_dna_file(input_file, &n, &map, &map_size);
+    if (!views)
+      return 1;
+  } else {
+    sequences = read_dna_file(input_file, &n);
+    if (!sequences)
+      return 1;
   }
+  printf("Tempo gasto para ler a entrada: %.6f segundos\n",
+         wall_time() - load_start);
 
-  int length = 0;
-  if (n > 0)
-    length = strlen(sequences[0]);
+  if (!keys && n > 0)
+    length = views ? views[0].len : (int)strlen(sequences[0]);
 
-  clock_t start = clock();
-  sequential_sort(sequences, n);
-  clock_t end = clock();
-  double cpu_time_used = ((double)(end - start)) / CLOCKS_PER_SEC;
+  dna_key *sorted_keys = NULL;
+  double start = wall_time();
+  int ok;
+  if (keys) {
+    ok = n > 0 ? sort_keys(keys, n, mode) : 1;
+    sorted_keys = keys;
+  } else if (views) {
+    ok = sequential_sort_views(views, n, mode, &sorted_keys);
+  } else {
+    ok = sequential_sort(sequences, n, mode);
+  }
+  double time_used = wall_time() - start;
 
   printf("Ordenacao concluida!\n");
-  printf("Tempo gasto para ordenar: %.6f segundos\n", cpu_time_used);
+  printf("Tempo gasto para ordenar: %.6f segundos\n", time_used);
 
-  // salvar resultados (mantemos o caminho existente)
-  save_results_to_file(n, length, cpu_time_used);
+  save_results_to_file(n, length, time_used);
 
   // escrever sequencias ordenadas
-  write_dna_file(output_file, sequences, n);
+  if (format == FORMAT_BINARY) {
+    dna_key *packed =
+        sorted_keys ? sorted_keys : pack_for_binary(sequences, views, n);
+    if (packed)
+      write_dna_binary(output_file, packed, n);
+    else
+      ok = 0;
+    if (packed != sorted_keys)
+      free(packed);
+  } else if (sorted_keys || views) {
+    write_dna_result(output_file, sorted_keys, views, n);
+  } else {
+    write_dna_file(output_file, sequences, n);
+  }
 
-  for (int i = 0; i < n; i++)
-    free(sequences[i]);
-  free(sequences);
+  // na entrada binaria sorted_keys e o proprio vetor lido
+  free(sorted_keys);
+  free(views);
+  if (map)
+    munmap(map, map_size);
+  if (sequences) {
+    for (int i = 0; i < n; i++)
+      free(sequences[i]);
+    free(sequences);
+  }
 
-  return 0;
-}
\ No newline at end of file
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,722 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+// redes de ordenação vetoriais na base do merge sort (escolhidas em execução)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_SIMD_KERNELS 1
+#endif
+
+// valores entre 10-20 geralmente sao otimos
+#define INSERTION_THRESHOLD 16
+#define NUM_BALDES 10  // baldes por processo (padrão do -k)
+// amostras por balde (padrão do -a); mais amostras, baldes mais parelhos
+#define SAMPLES_PER_BUCKET 16
+
+// Protótipos das funções
+void insertion_sort(int *lista, int left, int right);
+void merge(const int *src, int *dst, int left, int mid, int right);
+void splitsort_buffer(int *lista, int *aux, int n);
+int select_base_kernel(const char *name);
+const char *base_kernel_name(void);
+int sort_base_runs(int *lista, int n);
+void splitsort(int *lista, int left, int right);
+void imprime(int *lista, int size, int rank);
+int num_threads(void);
+void parallel_bucket_sort(int **local_arr, int *local_n, int buckets_per_rank,
+                          int oversampling, MPI_Comm comm);
+
+// sem -q, só as listas de até este tamanho são impressas
+#define PRINT_LIMIT 64
+static int quiet = 0;
+
+int main(int argc, char *argv[]) {
+    int rank, size;
+
+    // so a thread principal chama o MPI; as threads ordenam os baldes
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    // -t N: threads por processo
+    // -n elementos, -m maior valor (exclusivo), -d uniforme|enviesada: entrada
+    // -k baldes por processo, -a amostras por balde
+    // -i: base do merge sort (redes vetoriais ou insertion sort)
+    // -q: não lista os vetores
+    int total_n = 30;
+    int max_value = 100;
+    int skewed = 0;
+    int buckets_per_rank = NUM_BALDES;
+    int oversampling = SAMPLES_PER_BUCKET;
+    select_base_kernel("auto");
+    int opt;
+    int usage = 0;
+    while ((opt = getopt(argc, argv, "t:n:m:d:k:a:qi:")) != -1) {
+        if (opt == 't' && atoi(optarg) > 0) {
+#ifdef _OPENMP
+            omp_set_num_threads(atoi(optarg));
+#endif
+        } else if (opt == 'n' && atoi(optarg) > 0) {
+            total_n = atoi(optarg);
+        } else if (opt == 'm' && atoi(optarg) > 0) {
+            max_value = atoi(optarg);
+        } else if (opt == 'd' && strcmp(optarg, "uniforme") == 0) {
+            skewed = 0;
+        } else if (opt == 'd' && strcmp(optarg, "enviesada") == 0) {
+            skewed = 1;
+        } else if (opt == 'k' && atoi(optarg) > 0) {
+            buckets_per_rank = atoi(optarg);
+        } else if (opt == 'i' && select_base_kernel(optarg)) {
+            // aceito só se a CPU suportar
+        } else if (opt == 'a' && atoi(optarg) > 0) {
+            oversampling = atoi(optarg);
+        } else if (opt == 'q') {
+            quiet = 1;
+        } else {
+            usage = 1;
+        }
+    }
+    if (usage) {
+        if (rank == 0) {
+            printf("Uso: %s [-t threads_por_processo] [-n elementos] [-m maior_valor] "
+                   "[-d uniforme|enviesada] [-k baldes_por_processo] "
+                   "[-a amostras_por_balde] [-i auto|escalar|sse4|avx2] [-q]\n", argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    if (rank == 0) {
+        printf("%d processos x %d threads, %d baldes, base %s\n", size, num_threads(),
+               size * buckets_per_rank, base_kernel_name());
+    }
+
+    // Distribuição; os primeiros processos ficam com o resto
+    int *counts = (int*)malloc(size * sizeof(int));
+    int *displs = (int*)malloc(size * sizeof(int));
+    for (int p = 0; p < size; p++) {
+        counts[p] = total_n / size + (p < total_n % size ? 1 : 0);
+        displs[p] = p == 0 ? 0 : displs[p - 1] + counts[p - 1];
+    }
+    int local_n = counts[rank];
+    int *local_arr = (int*)malloc((local_n > 0 ? local_n : 1) * sizeof(int));
+
+    long long input_sum = 0;
+    if (rank == 0) {
+        // enviesada: u^4 concentra quase tudo perto de 0, o caso em que
+        // baldes de largura fixa entre min e max ficam quase todos vazios
+        int *global_arr = (int*)malloc(total_n * sizeof(int));
+        srand(time(NULL));
+        for (int i = 0; i < total_n; i++) {
+            double u = rand() / ((double)RAND_MAX + 1);
+            global_arr[i] = skewed ? (int)(max_value * u * u * u * u) : (int)(max_value * u);
+            input_sum += global_arr[i];
+        }
+        printf("Processo %d: Dados globais originais:\n", rank);
+        imprime(global_arr, total_n, rank);
+
+        MPI_Scatterv(global_arr, counts, displs, MPI_INT,
+                     local_arr, local_n, MPI_INT, 0, MPI_COMM_WORLD);
+        free(global_arr);
+    } else {
+        MPI_Scatterv(NULL, NULL, NULL, MPI_INT,
+                     local_arr, local_n, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
+    parallel_bucket_sort(&local_arr, &local_n, buckets_per_rank, oversampling, MPI_COMM_WORLD);
+    double sort_time = MPI_Wtime() - start_time, max_time;
+    MPI_Reduce(&sort_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    // Coleta: tamanhos finais e depois os dados em ordem de processo
+    MPI_Gather(&local_n, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        displs[0] = 0;
+        for (int p = 1; p < size; p++) {
+            displs[p] = displs[p - 1] + counts[p - 1];
+        }
+        int *sorted_global = (int*)malloc(total_n * sizeof(int));
+        MPI_Gatherv(local_arr, local_n, MPI_INT,
+                    sorted_global, counts, displs, MPI_INT, 0, MPI_COMM_WORLD);
+
+        printf("\nProcesso %d: Dados globais ordenados:\n", rank);
+        imprime(sorted_global, total_n, rank);
+
+        // mesma quantidade, mesma soma e em ordem
+        int ok = displs[size - 1] + counts[size - 1] == total_n;
+        long long output_sum = 0;
+        for (int i = 0; i < total_n; i++) {
+            output_sum += sorted_global[i];
+            if (i > 0 && sorted_global[i - 1] > sorted_global[i]) ok = 0;
+        }
+        ok = ok && output_sum == input_sum;
+        printf("Processo %d: Ordenacao global: %s\n", rank, ok ? "CORRETO" : "INCORRETO");
+        printf("Processo %d: Tempo de execucao: %.6f segundos\n", rank, max_time);
+        free(sorted_global);
+    } else {
+        MPI_Gatherv(local_arr, local_n, MPI_INT,
+                    NULL, NULL, NULL, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+
+    free(counts);
+    free(displs);
+    free(local_arr);
+    MPI_Finalize();
+    return 0;
+}
+
+// índice do balde de x: quantos limites são <= x (limites ordenados)
+static inline int bucket_of(const int *bounds, int num_bounds, int x) {
+    int lo = 0, hi = num_bounds;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (bounds[mid] <= x) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Limites dos baldes por amostra: cada processo tira amostras em posições
+// regulares do vetor local (ainda desordenado, então valem como aleatórias),
+// todos recebem todas (MPI_Allgather) e ordenam o conjunto, que é pequeno.
+// O limite i é o quantil (i+1)/B da amostra, então cada balde fica com
+// ~N/B elementos mesmo com a entrada concentrada numa faixa estreita.
+// Só é chamada com N > 0, então a amostra nunca é vazia
+static void sample_bounds(const int *data, int n, int *bounds, int num_buckets,
+                          int oversampling, MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+
+    int per_rank = (num_buckets * oversampling + size - 1) / size;
+    int local_count = n < per_rank ? n : per_rank;
+    int *local_sample = (int*)malloc((per_rank > 0 ? per_rank : 1) * sizeof(int));
+    for (int i = 0; i < local_count; i++) {
+        local_sample[i] = data[(long long)n * (2 * i + 1) / (2 * local_count)];
+    }
+
+    int *sample_counts = (int*)malloc(size * sizeof(int));
+    int *sample_displs = (int*)malloc(size * sizeof(int));
+    MPI_Allgather(&local_count, 1, MPI_INT, sample_counts, 1, MPI_INT, comm);
+    sample_displs[0] = 0;
+    for (int p = 1; p < size; p++) {
+        sample_displs[p] = sample_displs[p - 1] + sample_counts[p - 1];
+    }
+    int total = sample_displs[size - 1] + sample_counts[size - 1];
+    int *sample = (int*)malloc((total > 0 ? total : 1) * sizeof(int));
+    MPI_Allgatherv(local_sample, local_count, MPI_INT,
+                   sample, sample_counts, sample_displs, MPI_INT, comm);
+
+    splitsort(sample, 0, total - 1);
+    for (int i = 0; i < num_buckets - 1; i++) {
+        bounds[i] = sample[(long long)(i + 1) * total / num_buckets];
+    }
+
+    free(local_sample);
+    free(sample_counts);
+    free(sample_displs);
+    free(sample);
+}
+
+// Bucket sort distribuído:
+// 1. min/max globais (MPI_Allreduce) e limites dos baldes: um valor por
+//    balde se a faixa couber nos baldes, senão por amostra
+// 2. contagem local por balde, somada entre os processos: cada processo
+//    conhece o tamanho exato de todos os baldes
+// 3. baldes inteiros e consecutivos vão para o mesmo processo, cortados
+//    pelo meio de cada balde em múltiplos de N/p
+// 4. espalhamento por balde (contagem, prefixo e escrita, uma faixa por
+//    thread) e uma troca MPI_Alltoallv dos dados, mais uma das contagens
+//    por balde
+// 5. os elementos recebidos são reagrupados por balde com uma cópia por
+//    (origem, balde) e cada balde é ordenado por uma thread, com o splitsort
+// Sem ordenação local antes da troca e sem rodadas de separadores: para
+// chaves inteiras bem espalhadas basta uma amostra pequena
+void parallel_bucket_sort(int **local_arr, int *local_n, int buckets_per_rank,
+                          int oversampling, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    int n = *local_n;
+    int *data = *local_arr;
+
+    // 1. Intervalo global, {-min, max} em uma só redução (em long long, -INT_MIN
+    // não cabe em int); vetor vazio entra como min = INT_MAX, max = INT_MIN
+    int local_min = INT_MAX, local_max = INT_MIN;
+    for (int i = 0; i < n; i++) {
+        if (data[i] < local_min) local_min = data[i];
+        if (data[i] > local_max) local_max = data[i];
+    }
+    long long local_ext[2] = {-(long long)local_min, local_max};
+    long long ext[2];
+    MPI_Allreduce(local_ext, ext, 2, MPI_LONG_LONG, MPI_MAX, comm);
+    long long min_val = -ext[0], max_val = ext[1];
+
+    int num_buckets = size * buckets_per_rank;
+    int num_bounds = num_buckets - 1;
+    int *bounds = (int*)malloc((num_bounds > 0 ? num_bounds : 1) * sizeof(int));
+    if (max_val - min_val < num_buckets) {
+        // faixa estreita (ou tudo vazio): cada valor no seu balde, a divisão
+        // mais fina possível, sem amostra; os limites que passam de max
+        // ficam em max e deixam os últimos baldes vazios
+        for (int i = 0; i < num_bounds; i++) {
+            long long b = min_val + i + 1;
+            bounds[i] = (int)(b < max_val ? b : max_val);
+        }
+    } else {
+        sample_bounds(data, n, bounds, num_buckets, oversampling, comm);
+    }
+
+    // 2. Balde de cada elemento e contagens por faixa de thread
+    int nranges = num_threads();
+    int *bucket = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    int *range_counts = (int*)calloc((size_t)nranges * num_buckets, sizeof(int));
+
+    #pragma omp parallel for schedule(static)
+    for (int r = 0; r < nranges; r++) {
+        int lo = (long long)n * r / nranges;
+        int hi = (long long)n * (r + 1) / nranges;
+        int *my_counts = &range_counts[(size_t)r * num_buckets];
+        for (int i = lo; i < hi; i++) {
+            bucket[i] = bucket_of(bounds, num_bounds, data[i]);
+            my_counts[bucket[i]]++;
+        }
+    }
+
+    long long *bucket_counts = (long long*)calloc(num_buckets, sizeof(long long));
+    long long *global_counts = (long long*)malloc(num_buckets * sizeof(long long));
+    for (int r = 0; r < nranges; r++) {
+        for (int b = 0; b < num_buckets; b++) {
+            bucket_counts[b] += range_counts[(size_t)r * num_buckets + b];
+        }
+    }
+    MPI_Allreduce(bucket_counts, global_counts, num_buckets, MPI_LONG_LONG, MPI_SUM, comm);
+
+    // 3. Dono de cada balde: o processo em cuja fatia de N/p cai o meio do
+    // balde. É não decrescente em b, então cada processo fica com baldes
+    // consecutivos e a ordem global segue a ordem dos processos
+    long long total = 0;
+    for (int b = 0; b < num_buckets; b++) total += global_counts[b];
+    int *owner = (int*)malloc(num_buckets * sizeof(int));
+    long long before = 0;
+    for (int b = 0; b < num_buckets; b++) {
+        long long middle = before + global_counts[b] / 2;
+        owner[b] = total > 0 ? (int)(middle * size / total) : 0;
+        if (owner[b] >= size) owner[b] = size - 1;
+        before += global_counts[b];
+    }
+
+    // 4. Espalhamento: posição de escrita de cada (faixa, balde) no
+    // send_buffer, balde a balde; como o dono cresce com o balde, os
+    // elementos de cada destino ficam contíguos
+    int *send_counts = (int*)calloc(size, sizeof(int));
+    for (int b = 0; b < num_buckets; b++) {
+        send_counts[owner[b]] += (int)bucket_counts[b];
+    }
+    int pos = 0;
+    for (int b = 0; b < num_buckets; b++) {
+        for (int r = 0; r < nranges; r++) {
+            int count = range_counts[(size_t)r * num_buckets + b];
+            range_counts[(size_t)r * num_buckets + b] = pos;
+            pos += count;
+        }
+    }
+
+    int *send_buffer = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    #pragma omp parallel for schedule(static)
+    for (int r = 0; r < nranges; r++) {
+        int lo = (long long)n * r / nranges;
+        int hi = (long long)n * (r + 1) / nranges;
+        int *my_pos = &range_counts[(size_t)r * num_buckets];
+        for (int i = lo; i < hi; i++) {
+            send_buffer[my_pos[bucket[i]]++] = data[i];
+        }
+    }
+
+    int *recv_counts = (int*)malloc(size * sizeof(int));
+    MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
+    int *send_displs = (int*)malloc(size * sizeof(int));
+    int *recv_displs = (int*)malloc(size * sizeof(int));
+    send_displs[0] = recv_displs[0] = 0;
+    for (int p = 1; p < size; p++) {
+        send_displs[p] = send_displs[p - 1] + send_counts[p - 1];
+        recv_displs[p] = recv_displs[p - 1] + recv_counts[p - 1];
+    }
+    int total_recv = recv_displs[size - 1] + recv_counts[size - 1];
+
+    // Desbalanceamento: maior processo em relação à média n/p
+    long long my_recv = total_recv, max_recv;
+    MPI_Allreduce(&my_recv, &max_recv, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    if (rank == 0 && total > 0) {
+        printf("Processo %d: Desbalanceamento: maior processo %lld, media %.1f (%.3fx)\n",
+               rank, max_recv, (double)total / size, max_recv * (double)size / total);
+    }
+
+    int *received = (int*)malloc((total_recv > 0 ? total_recv : 1) * sizeof(int));
+    MPI_Alltoallv(send_buffer, send_counts, send_displs, MPI_INT,
+                  received, recv_counts, recv_displs, MPI_INT, comm);
+
+    // 5. Baldes deste processo: [first, last); o início de cada um sai das
+    // contagens globais, sem nova contagem
+    int first = 0;
+    while (first < num_buckets && owner[first] < rank) first++;
+    int last = first;
+    while (last < num_buckets && owner[last] == rank) last++;
+    int mine = last - first;
+    int *start = (int*)malloc((mine + 1) * sizeof(int));
+    start[0] = 0;
+    for (int b = first; b < last; b++) {
+        start[b - first + 1] = start[b - first] + (int)global_counts[b];
+    }
+
+    // Cada origem mandou os seus baldes em ordem, um trecho por balde; junto
+    // vão as contagens locais desses baldes (uma MPI_Alltoallv a mais, de
+    // num_buckets valores). Com elas o destino de cada trecho é conhecido e
+    // o reagrupamento vira uma cópia por (origem, balde), em paralelo, sem
+    // buscar o balde de cada elemento de novo
+    int *count_send = (int*)calloc(size, sizeof(int));
+    int *count_send_displs = (int*)malloc(size * sizeof(int));
+    for (int b = 0; b < num_buckets; b++) count_send[owner[b]]++;
+    count_send_displs[0] = 0;
+    for (int p = 1; p < size; p++) {
+        count_send_displs[p] = count_send_displs[p - 1] + count_send[p - 1];
+    }
+    int *count_recv = (int*)malloc(size * sizeof(int));
+    int *count_recv_displs = (int*)malloc(size * sizeof(int));
+    for (int q = 0; q < size; q++) {
+        count_recv[q] = mine;
+        count_recv_displs[q] = q * mine;
+    }
+    long long *source_counts = (long long*)malloc(((size_t)size * mine + 1) * sizeof(long long));
+    MPI_Alltoallv(bucket_counts, count_send, count_send_displs, MPI_LONG_LONG,
+                  source_counts, count_recv, count_recv_displs, MPI_LONG_LONG, comm);
+
+    // origem e destino de cada trecho: as origens em ordem de processo
+    // dentro de cada balde
+    int *piece_src = (int*)malloc(((size_t)size * mine + 1) * sizeof(int));
+    int *piece_dst = (int*)malloc(((size_t)size * mine + 1) * sizeof(int));
+    int *fill = (int*)malloc((mine + 1) * sizeof(int));
+    memcpy(fill, start, (mine + 1) * sizeof(int));
+    for (int q = 0; q < size; q++) {
+        int src = recv_displs[q];
+        for (int j = 0; j < mine; j++) {
+            int piece = q * mine + j;
+            piece_src[piece] = src;
+            piece_dst[piece] = fill[j];
+            src += (int)source_counts[piece];
+            fill[j] += (int)source_counts[piece];
+        }
+    }
+
+    int *sorted = (int*)malloc((total_recv > 0 ? total_recv : 1) * sizeof(int));
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (int piece = 0; piece < size * mine; piece++) {
+        memcpy(sorted + piece_dst[piece], received + piece_src[piece],
+               source_counts[piece] * sizeof(int));
+    }
+
+    // baldes inteiros por thread; dynamic porque os tamanhos variam. O
+    // vetor recebido já foi reagrupado e serve de auxiliar do merge sort,
+    // cada balde na sua própria faixa
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int b = first; b < last; b++) {
+        int lo = start[b - first];
+        int hi = start[b - first + 1];
+        if (hi - lo > 1) splitsort_buffer(sorted + lo, received + lo, hi - lo);
+    }
+
+    if (!quiet && total <= PRINT_LIMIT) {
+        printf("Processo %d: Baldes %d a %d: ", rank, first, last - 1);
+        imprime(sorted, total_recv, rank);
+    }
+
+    free(*local_arr);
+    *local_arr = sorted;
+    *local_n = total_recv;
+
+    free(bounds);
+    free(bucket);
+    free(range_counts);
+    free(bucket_counts);
+    free(global_counts);
+    free(owner);
+    free(send_counts);
+    free(send_buffer);
+    free(recv_counts);
+    free(send_displs);
+    free(recv_displs);
+    free(received);
+    free(start);
+    free(count_send);
+    free(count_send_displs);
+    free(count_recv);
+    free(count_recv_displs);
+    free(source_counts);
+    free(piece_src);
+    free(piece_dst);
+    free(fill);
+}
+
+// insertionsort para subvetores pequenos
+void insertion_sort(int *lista, int left, int right) {
+    for (int i = left + 1; i <= right; i++) {
+        int key = lista[i];
+        int j = i - 1;
+        while (j >= left && lista[j] > key) {
+            lista[j + 1] = lista[j];
+            j--;
+        }
+        lista[j + 1] = key;
+    }
+}
+
+// Base do merge sort: em vez do insertion sort em trechos de
+// INSERTION_THRESHOLD, blocos de tamanho fixo ordenados por redes bitônicas
+// dentro dos registradores vetoriais (min/max e permutações, sem desvios).
+// O conjunto de instruções é escolhido em tempo de execução (-i); sem x86,
+// ou sem suporte na CPU, fica o insertion sort
+enum base_kernel { KERNEL_SCALAR, KERNEL_SSE4, KERNEL_AVX2 };
+static int base_kernel = KERNEL_SCALAR;
+
+#ifdef HAVE_SIMD_KERNELS
+// compara-troca cada elemento com o da posição idx: as posições com bit 1
+// em mask ficam com o máximo, as outras com o mínimo
+#define AVX2_CMPX(v, idx, mask) do { \
+        __m256i p_ = _mm256_permutevar8x32_epi32(v, idx); \
+        v = _mm256_blend_epi32(_mm256_min_epi32(v, p_), _mm256_max_epi32(v, p_), mask); \
+    } while (0)
+
+// sequência bitônica de 8 -> ordenada (distâncias 4, 2 e 1)
+__attribute__((target("avx2")))
+static inline __m256i avx2_clean8(__m256i v) {
+    AVX2_CMPX(v, _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3), 0xF0);
+    AVX2_CMPX(v, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5), 0xCC);
+    AVX2_CMPX(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6), 0xAA);
+    return v;
+}
+
+// 8 elementos de um registrador: pares e quartetos em sentidos alternados
+// formam uma sequência bitônica, que o clean8 termina
+__attribute__((target("avx2")))
+static inline __m256i avx2_sort8(__m256i v) {
+    AVX2_CMPX(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6), 0x66);
+    AVX2_CMPX(v, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5), 0x3C);
+    AVX2_CMPX(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6), 0x5A);
+    return avx2_clean8(v);
+}
+
+// a e b ordenados -> a com os 8 menores e b com os 8 maiores, ordenados.
+// a crescente contra b invertido: min e max são bitônicos
+__attribute__((target("avx2")))
+static inline void avx2_merge16(__m256i *a, __m256i *b) {
+    __m256i r = _mm256_permutevar8x32_epi32(*b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    __m256i lo = _mm256_min_epi32(*a, r);
+    __m256i hi = _mm256_max_epi32(*a, r);
+    *a = avx2_clean8(lo);
+    *b = avx2_clean8(hi);
+}
+
+// ordena x[0..32) em quatro registradores
+__attribute__((target("avx2")))
+static void avx2_sort32(int *x) {
+    const __m256i rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    __m256i v0 = avx2_sort8(_mm256_loadu_si256((const __m256i*)x));
+    __m256i v1 = avx2_sort8(_mm256_loadu_si256((const __m256i*)(x + 8)));
+    __m256i v2 = avx2_sort8(_mm256_loadu_si256((const __m256i*)(x + 16)));
+    __m256i v3 = avx2_sort8(_mm256_loadu_si256((const __m256i*)(x + 24)));
+    avx2_merge16(&v0, &v1);
+    avx2_merge16(&v2, &v3);
+    // 16 + 16: a segunda metade invertida fica casada com a primeira; cada
+    // metade resultante é bitônica (distância 8 entre registradores e clean8)
+    __m256i r3 = _mm256_permutevar8x32_epi32(v3, rev);
+    __m256i r2 = _mm256_permutevar8x32_epi32(v2, rev);
+    __m256i l0 = _mm256_min_epi32(v0, r3), h0 = _mm256_max_epi32(v0, r3);
+    __m256i l1 = _mm256_min_epi32(v1, r2), h1 = _mm256_max_epi32(v1, r2);
+    _mm256_storeu_si256((__m256i*)x, avx2_clean8(_mm256_min_epi32(l0, l1)));
+    _mm256_storeu_si256((__m256i*)(x + 8), avx2_clean8(_mm256_max_epi32(l0, l1)));
+    _mm256_storeu_si256((__m256i*)(x + 16), avx2_clean8(_mm256_min_epi32(h0, h1)));
+    _mm256_storeu_si256((__m256i*)(x + 24), avx2_clean8(_mm256_max_epi32(h0, h1)));
+}
+
+// mesma ideia com 4 elementos por registrador (SSE4.1 tem min/max de 32 bits)
+#define SSE4_CMPX(v, shuffle, mask16) do { \
+        __m128i p_ = _mm_shuffle_epi32(v, shuffle); \
+        v = _mm_blend_epi16(_mm_min_epi32(v, p_), _mm_max_epi32(v, p_), mask16); \
+    } while (0)
+
+// sequência bitônica de 4 -> ordenada (distâncias 2 e 1)
+__attribute__((target("sse4.1")))
+static inline __m128i sse4_clean4(__m128i v) {
+    SSE4_CMPX(v, 0x4E, 0xF0);
+    SSE4_CMPX(v, 0xB1, 0xCC);
+    return v;
+}
+
+// a e b ordenados -> a com os 4 menores e b com os 4 maiores
+__attribute__((target("sse4.1")))
+static inline void sse4_merge8(__m128i *a, __m128i *b) {
+    __m128i r = _mm_shuffle_epi32(*b, 0x1B);
+    __m128i lo = _mm_min_epi32(*a, r);
+    __m128i hi = _mm_max_epi32(*a, r);
+    *a = sse4_clean4(lo);
+    *b = sse4_clean4(hi);
+}
+
+// ordena x[0..16): rede de 4 entradas nas colunas dos quatro
+// registradores, transposição (cada registrador vira uma sequência
+// ordenada de 4) e intercalações bitônicas 4 + 4 e 8 + 8
+__attribute__((target("sse4.1")))
+static void sse4_sort16(int *x) {
+    __m128i r0 = _mm_loadu_si128((const __m128i*)x);
+    __m128i r1 = _mm_loadu_si128((const __m128i*)(x + 4));
+    __m128i r2 = _mm_loadu_si128((const __m128i*)(x + 8));
+    __m128i r3 = _mm_loadu_si128((const __m128i*)(x + 12));
+    __m128i t;
+    t = _mm_min_epi32(r0, r1); r1 = _mm_max_epi32(r0, r1); r0 = t;
+    t = _mm_min_epi32(r2, r3); r3 = _mm_max_epi32(r2, r3); r2 = t;
+    t = _mm_min_epi32(r0, r2); r2 = _mm_max_epi32(r0, r2); r0 = t;
+    t = _mm_min_epi32(r1, r3); r3 = _mm_max_epi32(r1, r3); r1 = t;
+    t = _mm_min_epi32(r1, r2); r2 = _mm_max_epi32(r1, r2); r1 = t;
+
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1), t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1), t3 = _mm_unpackhi_epi32(r2, r3);
+    __m128i c0 = _mm_unpacklo_epi64(t0, t1), c1 = _mm_unpackhi_epi64(t0, t1);
+    __m128i c2 = _mm_unpacklo_epi64(t2, t3), c3 = _mm_unpackhi_epi64(t2, t3);
+    sse4_merge8(&c0, &c1);
+    sse4_merge8(&c2, &c3);
+
+    __m128i q3 = _mm_shuffle_epi32(c3, 0x1B), q2 = _mm_shuffle_epi32(c2, 0x1B);
+    __m128i l0 = _mm_min_epi32(c0, q3), h0 = _mm_max_epi32(c0, q3);
+    __m128i l1 = _mm_min_epi32(c1, q2), h1 = _mm_max_epi32(c1, q2);
+    _mm_storeu_si128((__m128i*)x, sse4_clean4(_mm_min_epi32(l0, l1)));
+    _mm_storeu_si128((__m128i*)(x + 4), sse4_clean4(_mm_max_epi32(l0, l1)));
+    _mm_storeu_si128((__m128i*)(x + 8), sse4_clean4(_mm_min_epi32(h0, h1)));
+    _mm_storeu_si128((__m128i*)(x + 12), sse4_clean4(_mm_max_epi32(h0, h1)));
+}
+#endif
+
+// -i auto|escalar|sse4|avx2 (auto: o maior que a CPU suporta)
+// retorna 0 se o nome for desconhecido ou a CPU não suportar
+int select_base_kernel(const char *name) {
+    int avx2 = 0, sse4 = 0;
+#ifdef HAVE_SIMD_KERNELS
+    __builtin_cpu_init();
+    avx2 = __builtin_cpu_supports("avx2");
+    sse4 = __builtin_cpu_supports("sse4.1");
+#endif
+    if (strcmp(name, "auto") == 0) {
+        base_kernel = avx2 ? KERNEL_AVX2 : sse4 ? KERNEL_SSE4 : KERNEL_SCALAR;
+    } else if (strcmp(name, "escalar") == 0) {
+        base_kernel = KERNEL_SCALAR;
+    } else if (strcmp(name, "sse4") == 0 && sse4) {
+        base_kernel = KERNEL_SSE4;
+    } else if (strcmp(name, "avx2") == 0 && avx2) {
+        base_kernel = KERNEL_AVX2;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+const char *base_kernel_name(void) {
+    switch (base_kernel) {
+    case KERNEL_AVX2: return "avx2, blocos de 32";
+    case KERNEL_SSE4: return "sse4, blocos de 16";
+    default: return "escalar, insertion sort";
+    }
+}
+
+// ordena lista[0..n) em trechos do tamanho da base e devolve esse tamanho;
+// a sobra no fim (menor que um bloco) vai para o insertion sort
+int sort_base_runs(int *lista, int n) {
+    int block = INSERTION_THRESHOLD;
+    int lo = 0;
+#ifdef HAVE_SIMD_KERNELS
+    if (base_kernel == KERNEL_AVX2) {
+        block = 32;
+        for (; lo + 32 <= n; lo += 32) avx2_sort32(lista + lo);
+    } else if (base_kernel == KERNEL_SSE4) {
+        block = 16;
+        for (; lo + 16 <= n; lo += 16) sse4_sort16(lista + lo);
+    }
+#endif
+    for (; lo < n; lo += block) {
+        int hi = lo + block - 1;
+        insertion_sort(lista, lo, hi < n ? hi : n - 1);
+    }
+    return block;
+}
+
+// intercala src[left..mid] e src[mid+1..right] em dst[left..right]
+void merge(const int *src, int *dst, int left, int mid, int right) {
+    int i = left, j = mid + 1, k = left;
+    while (i <= mid && j <= right) {
+        if (src[i] <= src[j]) dst[k++] = src[i++];
+        else dst[k++] = src[j++];
+    }
+    while (i <= mid) dst[k++] = src[i++];
+    while (j <= right) dst[k++] = src[j++];
+}
+
+// Merge sort de baixo para cima, sem recursão e sem alocar: trechos do
+// tamanho da base (sort_base_runs) e depois cada passada intercala pares de
+// trechos dobrando a largura, alternando origem e destino entre lista e aux
+// (n posições). Se o resultado terminar em aux, volta com uma cópia
+void splitsort_buffer(int *lista, int *aux, int n) {
+    int base = sort_base_runs(lista, n);
+    int *src = lista, *dst = aux;
+    for (int width = base; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width - 1;
+            int hi = lo + 2 * width - 1 < n ? lo + 2 * width - 1 : n - 1;
+            if (mid >= hi) memcpy(dst + lo, src + lo, (n - lo) * sizeof(int));
+            else merge(src, dst, lo, mid, hi);
+        }
+        int *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != lista) memcpy(lista, src, n * sizeof(int));
+}
+
+// ordena lista[left..right] com um único vetor auxiliar
+void splitsort(int *lista, int left, int right) {
+    int n = right - left + 1;
+    if (n <= INSERTION_THRESHOLD) {
+        insertion_sort(lista, left, right);
+        return;
+    }
+    int *aux = (int*)malloc(n * sizeof(int));
+    splitsort_buffer(lista + left, aux, n);
+    free(aux);
+}
+
+
+void imprime(int *lista, int size, int rank) {
+    if (quiet || size > PRINT_LIMIT) {
+        printf("P%d: [%d elementos]\n", rank, size);
+        return;
+    }
+    printf("P%d: [", rank);
+    for (int i = 0; i < size; i++) {
+        printf("%d", lista[i]);
+        if (i < size - 1) printf(", ");
+    }
+    printf("]\n");
+}
+
+// sem OpenMP o programa roda com uma thread por processo
+int num_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
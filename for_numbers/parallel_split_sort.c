@@ -1,191 +1,329 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include <mpi.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+// redes de ordenação vetoriais na base do merge sort (escolhidas em execução)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAVE_SIMD_KERNELS 1
+#endif
 
 #define INSERTION_THRESHOLD 16
+// subvetores menores que isso sao ordenados sem criar novas tarefas
+#define TASK_THRESHOLD 4096
+
+// escolha dos separadores globais
+typedef struct {
+    int histogram;     // 0: amostras no processo 0; 1: refinamento por histograma
+    double tolerance;  // desvio máximo de cada balde, em fração de n/p (histograma)
+    int oversampling;  // amostras por separador e por processo / sondas por rodada
+} splitter_options;
+
+// limite de rodadas do histograma (32 bits caem pela metade a cada rodada)
+#define HISTOGRAM_MAX_ROUNDS 64
+
+// redistribuição: Alltoallv e depois intercalação, ou envio em pedaços com
+// intercalação das faixas conforme chegam
+enum exchange_mode { EXCHANGE_ALLTOALL, EXCHANGE_PIPELINE };
+// elementos por mensagem no modo pipeline
+#define EXCHANGE_CHUNK (1 << 16)
 
 void insertion_sort(int *lista, int left, int right);
-void merge(int *lista, int left, int mid, int right);
+void merge(const int *src, int *dst, int left, int mid, int right);
+void splitsort_buffer(int *lista, int *aux, int n);
+int select_base_kernel(const char *name);
+const char *base_kernel_name(void);
+int sort_base_runs(int *lista, int n);
 void splitsort(int *lista, int left, int right);
+void parallel_local_sort(int *lista, int n);
+int num_threads(void);
+void merge_runs(const int *src, const int *counts, const int *displs, int runs, int *dst);
+void exchange_and_merge(const int *send, const int *send_counts, const int *send_displs,
+                        const int *recv_counts, const int *recv_displs, int *dst, MPI_Comm comm);
+int histogram_splitters(const int *sorted, int n, int *global_splitters,
+                        const splitter_options *opts, MPI_Comm comm);
+void split_ties(const int *sorted, int n, const int *splitters, int num_splitters,
+                int *cut, MPI_Comm comm);
 void imprime(int *lista, int size, int rank);
-void parallel_splitsort(int **local_arr, int *local_n, MPI_Comm comm);
+void parallel_splitsort(int **local_arr, int *local_n, const splitter_options *opts,
+                        int exchange, MPI_Comm comm);
+
+// tamanho do vetor de exemplo (entrada padrão, sem -n)
+#define DEMO_N 24
+// sem -q, só as listas de até este tamanho são impressas
+#define PRINT_LIMIT 64
+static int quiet = 0;
 
 int main(int argc, char *argv[]) {
     int rank, size;
     int *local_arr = NULL;
     int local_n;
     
-    MPI_Init(&argc, &argv);
+    // so a thread principal chama o MPI; as threads ficam nas ordenacoes locais
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &size);
     
-    // Gerar e distribuir dados
-    int total_n = 24;
-    local_n = total_n / size;
+    // -t N: threads por processo (modo hibrido, um processo por no ou socket)
+    // -s amostra|histograma, -b tolerancia, -a sobreamostragem: separadores
+    // -x alltoall|pipeline: redistribuição em bloco ou em pedaços sobrepostos
+    // -i: base do merge sort (redes vetoriais ou insertion sort)
+    // -n elementos, -m maior valor (exclusivo): entrada aleatória no lugar do
+    // vetor de exemplo; -q: não lista os vetores
+    splitter_options opts = {0, 0.05, 1};
+    int total_n = DEMO_N;
+    int random_input = 0;
+    int max_value = 100;
+    int exchange = EXCHANGE_ALLTOALL;
+    select_base_kernel("auto");
+    int opt;
+    int usage = 0;
+    while ((opt = getopt(argc, argv, "t:s:b:a:x:i:n:m:q")) != -1) {
+        if (opt == 't' && atoi(optarg) > 0) {
+#ifdef _OPENMP
+            omp_set_num_threads(atoi(optarg));
+#endif
+        } else if (opt == 's' && strcmp(optarg, "amostra") == 0) {
+            opts.histogram = 0;
+        } else if (opt == 's' && strcmp(optarg, "histograma") == 0) {
+            opts.histogram = 1;
+        } else if (opt == 'b' && atof(optarg) > 0) {
+            opts.tolerance = atof(optarg);
+        } else if (opt == 'i' && select_base_kernel(optarg)) {
+            // aceito só se a CPU suportar
+        } else if (opt == 'a' && atoi(optarg) > 0) {
+            opts.oversampling = atoi(optarg);
+        } else if (opt == 'x' && strcmp(optarg, "alltoall") == 0) {
+            exchange = EXCHANGE_ALLTOALL;
+        } else if (opt == 'x' && strcmp(optarg, "pipeline") == 0) {
+            exchange = EXCHANGE_PIPELINE;
+        } else if (opt == 'n' && atoi(optarg) > 0) {
+            total_n = atoi(optarg);
+            random_input = 1;
+        } else if (opt == 'm' && atoi(optarg) > 0) {
+            max_value = atoi(optarg);
+        } else if (opt == 'q') {
+            quiet = 1;
+        } else {
+            usage = 1;
+        }
+    }
+    if (usage) {
+        if (rank == 0) {
+            printf("Uso: %s [-t threads_por_processo] [-s amostra|histograma] "
+                   "[-b tolerancia] [-a sobreamostragem] [-x alltoall|pipeline] "
+                   "[-i auto|escalar|sse4|avx2] [-n elementos] [-m maior_valor] [-q]\n",
+                   argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    if (rank == 0) {
+        printf("%d processos x %d threads, base %s\n", size, num_threads(), base_kernel_name());
+    }
+    
+    // Distribuição; os primeiros processos ficam com o resto
+    int *counts = (int*)malloc(size * sizeof(int));
+    int *displs = (int*)malloc(size * sizeof(int));
+    for (int p = 0; p < size; p++) {
+        counts[p] = total_n / size + (p < total_n % size ? 1 : 0);
+        displs[p] = p == 0 ? 0 : displs[p - 1] + counts[p - 1];
+    }
+    local_n = counts[rank];
+    local_arr = (int*)malloc((local_n > 0 ? local_n : 1) * sizeof(int));
     
+    long long input_sum = 0;
     if (rank == 0) {
-        int global_arr[] = {22,7,13,18,2,17,1,14,20,6,10,24,15,9,21,3,16,19,23,4,11,12,5,8};
+        // sem -n, o vetor fixo de exemplo
+        int demo_arr[] = {22,7,13,18,2,17,1,14,20,6,10,24,15,9,21,3,16,19,23,4,11,12,5,8};
+        int *global_arr = demo_arr;
+        if (random_input) {
+            global_arr = (int*)malloc(total_n * sizeof(int));
+            srand(time(NULL));
+            for (int i = 0; i < total_n; i++) {
+                global_arr[i] = (int)(max_value * (rand() / ((double)RAND_MAX + 1)));
+            }
+        }
+        for (int i = 0; i < total_n; i++) {
+            input_sum += global_arr[i];
+        }
         printf("Processo %d: Dados globais originais:\n", rank);
         imprime(global_arr, total_n, rank);
         
-        local_arr = (int*)malloc(local_n * sizeof(int));
-        for (int i = 0; i < local_n; i++) {
-            local_arr[i] = global_arr[i];
-        }
-        
-        // Distribuir para outros processos
-        for (int i = 1; i < size; i++) {
-            MPI_Send(&global_arr[i * local_n], local_n, MPI_INT, i, 0, MPI_COMM_WORLD);
-        }
+        MPI_Scatterv(global_arr, counts, displs, MPI_INT,
+                     local_arr, local_n, MPI_INT, 0, MPI_COMM_WORLD);
+        if (global_arr != demo_arr) free(global_arr);
     } else {
-        local_arr = (int*)malloc(local_n * sizeof(int));
-        MPI_Recv(local_arr, local_n, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Scatterv(NULL, NULL, NULL, MPI_INT,
+                     local_arr, local_n, MPI_INT, 0, MPI_COMM_WORLD);
     }
     
     // Ordenação paralela
-    parallel_splitsort(&local_arr, &local_n, MPI_COMM_WORLD);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start_time = MPI_Wtime();
+    parallel_splitsort(&local_arr, &local_n, &opts, exchange, MPI_COMM_WORLD);
+    double sort_time = MPI_Wtime() - start_time, max_time;
+    MPI_Reduce(&sort_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
     
-    // Coletar resultados CORRETAMENTE
+    // Coleta: tamanhos finais e depois os dados em ordem de processo
+    MPI_Gather(&local_n, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
     if (rank == 0) {
-        int *sorted_global = (int*)malloc(total_n * sizeof(int));
-        int *recv_counts = (int*)malloc(size * sizeof(int));
-        int *recv_displs = (int*)malloc(size * sizeof(int));
-        
-        // Coletar tamanhos primeiro
-        recv_counts[0] = local_n;
-        for (int i = 1; i < size; i++) {
-            MPI_Recv(&recv_counts[i], 1, MPI_INT, i, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        }
-        
-        // Calcular deslocamentos
-        recv_displs[0] = 0;
-        for (int i = 1; i < size; i++) {
-            recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
-        }
-        
-        // Coletar dados
-        for (int i = 0; i < local_n; i++) {
-            sorted_global[i] = local_arr[i];
-        }
-        
-        for (int i = 1; i < size; i++) {
-            MPI_Recv(&sorted_global[recv_displs[i]], recv_counts[i], MPI_INT, i, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        displs[0] = 0;
+        for (int p = 1; p < size; p++) {
+            displs[p] = displs[p - 1] + counts[p - 1];
         }
+        int *sorted_global = (int*)malloc(total_n * sizeof(int));
+        MPI_Gatherv(local_arr, local_n, MPI_INT,
+                    sorted_global, counts, displs, MPI_INT, 0, MPI_COMM_WORLD);
         
         printf("\nProcesso %d: Dados globais ordenados:\n", rank);
         imprime(sorted_global, total_n, rank);
         
+        // mesma quantidade, mesma soma e em ordem
+        int ok = displs[size - 1] + counts[size - 1] == total_n;
+        long long output_sum = 0;
+        for (int i = 0; i < total_n; i++) {
+            output_sum += sorted_global[i];
+            if (i > 0 && sorted_global[i - 1] > sorted_global[i]) ok = 0;
+        }
+        ok = ok && output_sum == input_sum;
+        printf("Processo %d: Ordenacao global: %s\n", rank, ok ? "CORRETO" : "INCORRETO");
+        printf("Processo %d: Tempo de execucao: %.6f segundos\n", rank, max_time);
         free(sorted_global);
-        free(recv_counts);
-        free(recv_displs);
     } else {
-        // Enviar tamanho e depois dados
-        MPI_Send(&local_n, 1, MPI_INT, 0, 1, MPI_COMM_WORLD);  // tag 1: tamanho
-        MPI_Send(local_arr, local_n, MPI_INT, 0, 2, MPI_COMM_WORLD); // tag 2: dados
+        MPI_Gatherv(local_arr, local_n, MPI_INT,
+                    NULL, NULL, NULL, MPI_INT, 0, MPI_COMM_WORLD);
     }
     
+    free(counts);
+    free(displs);
     free(local_arr);
     MPI_Finalize();
     return 0;
 }
 
-void parallel_splitsort(int **local_arr, int *local_n, MPI_Comm comm) {
+void parallel_splitsort(int **local_arr, int *local_n, const splitter_options *opts,
+                        int exchange, MPI_Comm comm) {
     int rank, size;
     MPI_Comm_rank(comm, &rank);
     MPI_Comm_size(comm, &size);
     
-    if (*local_n == 0) return;
+    // processos vazios ainda participam das coletivas
     
     // 1. Ordenação local
-    splitsort(*local_arr, 0, *local_n - 1);
+    parallel_local_sort(*local_arr, *local_n);
     printf("Processo %d: Após ordenação local: ", rank);
     imprime(*local_arr, *local_n, rank);
     
-    // 2. Selecionar separadores locais
     int num_splitters = size - 1;
-    int *local_splitters = (int*)malloc(num_splitters * sizeof(int));
-    
-    for (int i = 0; i < num_splitters; i++) {
-        int index = (i + 1) * (*local_n) / size;
-        if (index >= *local_n) index = *local_n - 1;
-        local_splitters[i] = (*local_arr)[index];
-    }
-    
-    // 3. Coletar separadores no processo 0
+    int *global_splitters = (int*)malloc(num_splitters * sizeof(int));
+    int *local_splitters = NULL;
     int *all_splitters = NULL;
-    if (rank == 0) {
-        all_splitters = (int*)malloc(size * num_splitters * sizeof(int));
-    }
     
-    MPI_Gather(local_splitters, num_splitters, MPI_INT, 
-              all_splitters, num_splitters, MPI_INT, 0, comm);
-    
-    // 4. Processo 0 seleciona separadores globais
-    int *global_splitters = (int*)malloc(num_splitters * sizeof(int));
-    if (rank == 0) {
-        splitsort(all_splitters, 0, size * num_splitters - 1);
-        for (int i = 0; i < num_splitters; i++) {
-            int index = (i + 1) * (size * num_splitters) / size;
-            if (index >= size * num_splitters) index = size * num_splitters - 1;
-            global_splitters[i] = all_splitters[index];
+    if (opts->histogram) {
+        // 2-5. Separadores refinados por histograma global, sem processo 0
+        int rounds = histogram_splitters(*local_arr, *local_n, global_splitters, opts, comm);
+        if (rank == 0) {
+            printf("Processo %d: Separadores por histograma (%d rodadas): ", rank, rounds);
+            imprime(global_splitters, num_splitters, rank);
+        }
+    } else {
+        // 2. Selecionar separadores locais (oversampling por separador)
+        int num_samples = opts->oversampling * size - 1;
+        local_splitters = (int*)malloc(num_samples * sizeof(int));
+        
+        for (int i = 0; i < num_samples; i++) {
+            int index = (long long)(i + 1) * (*local_n) / (num_samples + 1);
+            if (index >= *local_n) index = *local_n - 1;
+            local_splitters[i] = *local_n > 0 ? (*local_arr)[index] : INT_MAX;
+        }
+        
+        // 3. Coletar separadores no processo 0
+        int total_split = size * num_samples;
+        if (rank == 0) {
+            all_splitters = (int*)malloc(total_split * sizeof(int));
+        }
+        
+        MPI_Gather(local_splitters, num_samples, MPI_INT, 
+                  all_splitters, num_samples, MPI_INT, 0, comm);
+        
+        // 4. Processo 0 seleciona separadores globais
+        if (rank == 0) {
+            splitsort(all_splitters, 0, total_split - 1);
+            for (int i = 0; i < num_splitters; i++) {
+                int index = (i + 1) * total_split / size;
+                if (index >= total_split) index = total_split - 1;
+                global_splitters[i] = all_splitters[index];
+            }
+            printf("Processo %d: Separadores globais: ", rank);
+            imprime(global_splitters, num_splitters, rank);
         }
-        printf("Processo %d: Separadores globais: ", rank);
-        imprime(global_splitters, num_splitters, rank);
+        
+        // 5. Broadcast dos separadores globais
+        MPI_Bcast(global_splitters, num_splitters, MPI_INT, 0, comm);
     }
     
-    // 5. Broadcast dos separadores globais
-    MPI_Bcast(global_splitters, num_splitters, MPI_INT, 0, comm);
-    
     // 6. Redistribuição
-    int *send_counts = (int*)calloc(size, sizeof(int));
-    for (int i = 0; i < *local_n; i++) {
-        int element = (*local_arr)[i];
-        int target = 0;
-        while (target < num_splitters && element > global_splitters[target]) {
-            target++;
-        }
-        send_counts[target]++;
+    // O vetor local já está ordenado, então o destino p recebe uma faixa
+    // contígua dele: de cut[p-1] até cut[p], com as cópias de cada separador
+    // já repartidas pelo split_ties. As faixas seguem direto para o
+    // MPI_Alltoallv, sem classificar nem copiar elemento a elemento
+    int *cut = (int*)malloc((num_splitters > 0 ? num_splitters : 1) * sizeof(int));
+    split_ties(*local_arr, *local_n, global_splitters, num_splitters, cut, comm);
+    
+    int *send_counts = (int*)malloc(size * sizeof(int));
+    int *send_displs = (int*)malloc(size * sizeof(int));
+    for (int p = 0; p < size; p++) {
+        send_displs[p] = p == 0 ? 0 : cut[p - 1];
+        int end = p == size - 1 ? *local_n : cut[p];
+        send_counts[p] = end - send_displs[p];
     }
     
     int *recv_counts = (int*)malloc(size * sizeof(int));
     MPI_Alltoall(send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, comm);
     
-    int *send_displs = (int*)malloc(size * sizeof(int));
     int *recv_displs = (int*)malloc(size * sizeof(int));
-    send_displs[0] = recv_displs[0] = 0;
-    
+    recv_displs[0] = 0;
     for (int i = 1; i < size; i++) {
-        send_displs[i] = send_displs[i-1] + send_counts[i-1];
         recv_displs[i] = recv_displs[i-1] + recv_counts[i-1];
     }
     
     int total_recv = recv_displs[size-1] + recv_counts[size-1];
     
-    int *send_buffer = (int*)malloc(*local_n * sizeof(int));
-    int *temp_counts = (int*)calloc(size, sizeof(int));
-    
-    for (int i = 0; i < *local_n; i++) {
-        int element = (*local_arr)[i];
-        int target = 0;
-        while (target < num_splitters && element > global_splitters[target]) {
-            target++;
-        }
-        int pos = send_displs[target] + temp_counts[target];
-        send_buffer[pos] = element;
-        temp_counts[target]++;
+    // Desbalanceamento: maior balde em relação à média n/p
+    long long my_recv = total_recv, max_recv, total;
+    MPI_Allreduce(&my_recv, &max_recv, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    MPI_Allreduce(&my_recv, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0 && total > 0) {
+        printf("Processo %d: Desbalanceamento: maior balde %lld, media %.1f (%.3fx)\n",
+               rank, max_recv, (double)total / size, max_recv * (double)size / total);
     }
     
-    int *new_local_arr = (int*)malloc(total_recv * sizeof(int));
-    MPI_Alltoallv(send_buffer, send_counts, send_displs, MPI_INT,
-                 new_local_arr, recv_counts, recv_displs, MPI_INT, comm);
-    
+    int *merged = (int*)malloc(total_recv * sizeof(int));
+    if (exchange == EXCHANGE_PIPELINE) {
+        // 6-7. Envio em pedaços, intercalando as faixas conforme chegam
+        exchange_and_merge(*local_arr, send_counts, send_displs, recv_counts, recv_displs,
+                           merged, comm);
+    } else {
+        int *new_local_arr = (int*)malloc(total_recv * sizeof(int));
+        MPI_Alltoallv(*local_arr, send_counts, send_displs, MPI_INT,
+                     new_local_arr, recv_counts, recv_displs, MPI_INT, comm);
+        
+        // 7. Intercalação final: cada processo mandou uma faixa já ordenada,
+        // então basta intercalar as size faixas em vez de reordenar tudo
+        merge_runs(new_local_arr, recv_counts, recv_displs, size, merged);
+        free(new_local_arr);
+    }
     free(*local_arr);
-    *local_arr = new_local_arr;
+    *local_arr = merged;
     *local_n = total_recv;
-    
-    // 7. Ordenação final
-    splitsort(*local_arr, 0, *local_n - 1);
     printf("Processo %d: Após redistribuição: ", rank);
     imprime(*local_arr, *local_n, rank);
     
@@ -196,8 +334,181 @@ void parallel_splitsort(int **local_arr, int *local_n, MPI_Comm comm) {
     free(recv_counts);
     free(send_displs);
     free(recv_displs);
-    free(send_buffer);
-    free(temp_counts);
+    free(cut);
+}
+
+// quantos elementos do vetor ordenado são <= v
+static long long count_le(const int *sorted, int n, long long v) {
+    int lo = 0, hi = n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (sorted[mid] <= v) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Separadores por histograma: o separador i procura um valor v com
+// #{elementos <= v} perto do alvo (i+1)·N/p. Cada um guarda um intervalo
+// [lo, hi] com as contagens globais das pontas; a cada rodada são testadas
+// `oversampling` sondas igualmente espaçadas dentro dele, contadas no vetor
+// local (busca binária) e somadas por um único MPI_Allreduce. Para quando
+// todo separador estiver a no máximo tolerance/2 · N/p do alvo (então todo
+// balde fica dentro de tolerance · N/p) ou quando o intervalo não puder mais
+// ser dividido, o que só acontece com muitas chaves iguais
+// Retorna o número de rodadas
+int histogram_splitters(const int *sorted, int n, int *global_splitters,
+                        const splitter_options *opts, MPI_Comm comm) {
+    int size;
+    MPI_Comm_size(comm, &size);
+    int k = size - 1;
+    if (k == 0) return 0;
+    int s = opts->oversampling;
+    
+    long long local_n = n, total;
+    MPI_Allreduce(&local_n, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    // todos vazios: não há mínimo nem máximo para os intervalos e qualquer
+    // separador serve
+    if (total == 0) {
+        for (int i = 0; i < k; i++) global_splitters[i] = 0;
+        return 0;
+    }
+    // {-min, max} em uma só redução
+    long long local_ext[2] = {n > 0 ? -(long long)sorted[0] : LLONG_MIN,
+                              n > 0 ? (long long)sorted[n - 1] : LLONG_MIN};
+    long long ext[2];
+    MPI_Allreduce(local_ext, ext, 2, MPI_LONG_LONG, MPI_MAX, comm);
+    
+    long long *lo = (long long*)malloc(k * sizeof(long long));
+    long long *hi = (long long*)malloc(k * sizeof(long long));
+    long long *lo_count = (long long*)malloc(k * sizeof(long long));
+    long long *hi_count = (long long*)malloc(k * sizeof(long long));
+    long long *probe = (long long*)malloc(k * s * sizeof(long long));
+    long long *local_count = (long long*)malloc(k * s * sizeof(long long));
+    long long *count = (long long*)malloc(k * s * sizeof(long long));
+    for (int i = 0; i < k; i++) {
+        lo[i] = -ext[0] - 1;  // abaixo do mínimo: nenhum elemento <= lo
+        lo_count[i] = 0;
+        hi[i] = ext[1];
+        hi_count[i] = total;
+    }
+    double slack = opts->tolerance / 2 * total / size;
+    
+    int rounds = 0;
+    while (rounds < HISTOGRAM_MAX_ROUNDS) {
+        // todos os processos têm os mesmos intervalos e decidem igual
+        int pending = 0;
+        for (int i = 0; i < k; i++) {
+            long long target = (i + 1) * total / size;
+            int done = target - lo_count[i] <= slack || hi_count[i] - target <= slack ||
+                       hi[i] - lo[i] <= 1;
+            long long step = (hi[i] - lo[i]) / (s + 1);
+            if (step == 0) step = 1;
+            for (int j = 0; j < s; j++) {
+                long long v = lo[i] + step * (j + 1);
+                probe[i * s + j] = done ? hi[i] : (v < hi[i] ? v : hi[i] - 1);
+            }
+            pending += !done;
+        }
+        if (!pending) break;
+        
+        for (int q = 0; q < k * s; q++) {
+            local_count[q] = count_le(sorted, n, probe[q]);
+        }
+        MPI_Allreduce(local_count, count, k * s, MPI_LONG_LONG, MPI_SUM, comm);
+        rounds++;
+        
+        for (int i = 0; i < k; i++) {
+            long long target = (i + 1) * total / size;
+            for (int j = 0; j < s; j++) {
+                long long v = probe[i * s + j], c = count[i * s + j];
+                if (c <= target && v > lo[i]) {
+                    lo[i] = v;
+                    lo_count[i] = c;
+                }
+                if (c >= target && v < hi[i]) {
+                    hi[i] = v;
+                    hi_count[i] = c;
+                }
+            }
+        }
+    }
+    
+    // fica com a ponta mais perto do alvo, mantendo os separadores em ordem;
+    // intervalo sem divisão possível: o alvo cai dentro das cópias de hi, que
+    // o split_ties reparte, então fica com hi
+    for (int i = 0; i < k; i++) {
+        long long target = (i + 1) * total / size;
+        long long v = target - lo_count[i] <= hi_count[i] - target && hi[i] - lo[i] > 1
+                          ? lo[i] : hi[i];
+        if (v < INT_MIN) v = INT_MIN;
+        if (i > 0 && v < global_splitters[i - 1]) v = global_splitters[i - 1];
+        global_splitters[i] = (int)v;
+    }
+    
+    free(lo);
+    free(hi);
+    free(lo_count);
+    free(hi_count);
+    free(probe);
+    free(local_count);
+    free(count);
+    return rounds;
+}
+
+// Empates com os separadores. A regra "elemento > separador" manda toda
+// cópia de um separador para o mesmo destino; com poucos valores distintos
+// um processo recebe quase tudo. Aqui as chaves iguais ao separador i são
+// ordenadas por (chave, processo de origem, posição) e a sequência delas é
+// cortada no alvo (i+1)·N/p: a parte até o alvo fica no balde i, o resto
+// segue para os seguintes (separadores repetidos dividem a mesma sequência).
+// Se o alvo passa do fim da sequência, nada muda em relação à regra antiga
+// cut[i] = posição local do primeiro elemento que vai para depois do balde i
+// Custa um MPI_Allreduce e um MPI_Exscan com ~num_splitters valores
+void split_ties(const int *sorted, int n, const int *splitters, int num_splitters,
+                int *cut, MPI_Comm comm) {
+    int k = num_splitters;
+    if (k == 0) return;
+    int size, rank;
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_rank(comm, &rank);
+    
+    // [lt_0, le_0, lt_1, le_1, ..., n]: contagens locais, depois globais
+    long long *local_count = (long long*)malloc((2 * k + 1) * sizeof(long long));
+    long long *count = (long long*)malloc((2 * k + 1) * sizeof(long long));
+    long long *local_eq = (long long*)malloc(k * sizeof(long long));
+    long long *before = (long long*)malloc(k * sizeof(long long));
+    for (int i = 0; i < k; i++) {
+        local_count[2 * i] = count_le(sorted, n, (long long)splitters[i] - 1);
+        local_count[2 * i + 1] = count_le(sorted, n, splitters[i]);
+        local_eq[i] = local_count[2 * i + 1] - local_count[2 * i];
+    }
+    local_count[2 * k] = n;
+    MPI_Allreduce(local_count, count, 2 * k + 1, MPI_LONG_LONG, MPI_SUM, comm);
+    // cópias do separador i nos processos anteriores
+    MPI_Exscan(local_eq, before, k, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) {
+        for (int i = 0; i < k; i++) before[i] = 0;
+    }
+    
+    long long total = count[2 * k];
+    for (int i = 0; i < k; i++) {
+        long long target = (i + 1) * total / size;
+        // quantas cópias, no total, ficam até o balde i
+        long long keep = target - count[2 * i];
+        if (keep < 0) keep = 0;
+        if (keep > count[2 * i + 1] - count[2 * i]) keep = count[2 * i + 1] - count[2 * i];
+        // quantas dessas são deste processo
+        keep -= before[i];
+        if (keep < 0) keep = 0;
+        if (keep > local_eq[i]) keep = local_eq[i];
+        cut[i] = local_count[2 * i] + keep;
+    }
+    
+    free(local_count);
+    free(count);
+    free(local_eq);
+    free(before);
 }
 
 // Funções de ordenação (mantidas)
@@ -213,39 +524,448 @@ void insertion_sort(int *lista, int left, int right) {
     }
 }
 
-void merge(int *lista, int left, int mid, int right) {
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
-    int *left_arr = (int*)malloc(n1 * sizeof(int));
-    int *right_arr = (int*)malloc(n2 * sizeof(int));
-    
-    for (int i = 0; i < n1; i++) left_arr[i] = lista[left + i];
-    for (int i = 0; i < n2; i++) right_arr[i] = lista[mid + 1 + i];
-    
-    int i = 0, j = 0, k = left;
-    while (i < n1 && j < n2) {
-        if (left_arr[i] <= right_arr[j]) lista[k++] = left_arr[i++];
-        else lista[k++] = right_arr[j++];
+// Base do merge sort: em vez do insertion sort em trechos de
+// INSERTION_THRESHOLD, blocos de tamanho fixo ordenados por redes bitônicas
+// dentro dos registradores vetoriais (min/max e permutações, sem desvios).
+// O conjunto de instruções é escolhido em tempo de execução (-i); sem x86,
+// ou sem suporte na CPU, fica o insertion sort
+enum base_kernel { KERNEL_SCALAR, KERNEL_SSE4, KERNEL_AVX2 };
+static int base_kernel = KERNEL_SCALAR;
+
+#ifdef HAVE_SIMD_KERNELS
+// compara-troca cada elemento com o da posição idx: as posições com bit 1
+// em mask ficam com o máximo, as outras com o mínimo
+#define AVX2_CMPX(v, idx, mask) do { \
+        __m256i p_ = _mm256_permutevar8x32_epi32(v, idx); \
+        v = _mm256_blend_epi32(_mm256_min_epi32(v, p_), _mm256_max_epi32(v, p_), mask); \
+    } while (0)
+
+// sequência bitônica de 8 -> ordenada (distâncias 4, 2 e 1)
+__attribute__((target("avx2")))
+static inline __m256i avx2_clean8(__m256i v) {
+    AVX2_CMPX(v, _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3), 0xF0);
+    AVX2_CMPX(v, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5), 0xCC);
+    AVX2_CMPX(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6), 0xAA);
+    return v;
+}
+
+// 8 elementos de um registrador: pares e quartetos em sentidos alternados
+// formam uma sequência bitônica, que o clean8 termina
+__attribute__((target("avx2")))
+static inline __m256i avx2_sort8(__m256i v) {
+    AVX2_CMPX(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6), 0x66);
+    AVX2_CMPX(v, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5), 0x3C);
+    AVX2_CMPX(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6), 0x5A);
+    return avx2_clean8(v);
+}
+
+// a e b ordenados -> a com os 8 menores e b com os 8 maiores, ordenados.
+// a crescente contra b invertido: min e max são bitônicos
+__attribute__((target("avx2")))
+static inline void avx2_merge16(__m256i *a, __m256i *b) {
+    __m256i r = _mm256_permutevar8x32_epi32(*b, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    __m256i lo = _mm256_min_epi32(*a, r);
+    __m256i hi = _mm256_max_epi32(*a, r);
+    *a = avx2_clean8(lo);
+    *b = avx2_clean8(hi);
+}
+
+// ordena x[0..32) em quatro registradores
+__attribute__((target("avx2")))
+static void avx2_sort32(int *x) {
+    const __m256i rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+    __m256i v0 = avx2_sort8(_mm256_loadu_si256((const __m256i*)x));
+    __m256i v1 = avx2_sort8(_mm256_loadu_si256((const __m256i*)(x + 8)));
+    __m256i v2 = avx2_sort8(_mm256_loadu_si256((const __m256i*)(x + 16)));
+    __m256i v3 = avx2_sort8(_mm256_loadu_si256((const __m256i*)(x + 24)));
+    avx2_merge16(&v0, &v1);
+    avx2_merge16(&v2, &v3);
+    // 16 + 16: a segunda metade invertida fica casada com a primeira; cada
+    // metade resultante é bitônica (distância 8 entre registradores e clean8)
+    __m256i r3 = _mm256_permutevar8x32_epi32(v3, rev);
+    __m256i r2 = _mm256_permutevar8x32_epi32(v2, rev);
+    __m256i l0 = _mm256_min_epi32(v0, r3), h0 = _mm256_max_epi32(v0, r3);
+    __m256i l1 = _mm256_min_epi32(v1, r2), h1 = _mm256_max_epi32(v1, r2);
+    _mm256_storeu_si256((__m256i*)x, avx2_clean8(_mm256_min_epi32(l0, l1)));
+    _mm256_storeu_si256((__m256i*)(x + 8), avx2_clean8(_mm256_max_epi32(l0, l1)));
+    _mm256_storeu_si256((__m256i*)(x + 16), avx2_clean8(_mm256_min_epi32(h0, h1)));
+    _mm256_storeu_si256((__m256i*)(x + 24), avx2_clean8(_mm256_max_epi32(h0, h1)));
+}
+
+// mesma ideia com 4 elementos por registrador (SSE4.1 tem min/max de 32 bits)
+#define SSE4_CMPX(v, shuffle, mask16) do { \
+        __m128i p_ = _mm_shuffle_epi32(v, shuffle); \
+        v = _mm_blend_epi16(_mm_min_epi32(v, p_), _mm_max_epi32(v, p_), mask16); \
+    } while (0)
+
+// sequência bitônica de 4 -> ordenada (distâncias 2 e 1)
+__attribute__((target("sse4.1")))
+static inline __m128i sse4_clean4(__m128i v) {
+    SSE4_CMPX(v, 0x4E, 0xF0);
+    SSE4_CMPX(v, 0xB1, 0xCC);
+    return v;
+}
+
+// a e b ordenados -> a com os 4 menores e b com os 4 maiores
+__attribute__((target("sse4.1")))
+static inline void sse4_merge8(__m128i *a, __m128i *b) {
+    __m128i r = _mm_shuffle_epi32(*b, 0x1B);
+    __m128i lo = _mm_min_epi32(*a, r);
+    __m128i hi = _mm_max_epi32(*a, r);
+    *a = sse4_clean4(lo);
+    *b = sse4_clean4(hi);
+}
+
+// ordena x[0..16): rede de 4 entradas nas colunas dos quatro
+// registradores, transposição (cada registrador vira uma sequência
+// ordenada de 4) e intercalações bitônicas 4 + 4 e 8 + 8
+__attribute__((target("sse4.1")))
+static void sse4_sort16(int *x) {
+    __m128i r0 = _mm_loadu_si128((const __m128i*)x);
+    __m128i r1 = _mm_loadu_si128((const __m128i*)(x + 4));
+    __m128i r2 = _mm_loadu_si128((const __m128i*)(x + 8));
+    __m128i r3 = _mm_loadu_si128((const __m128i*)(x + 12));
+    __m128i t;
+    t = _mm_min_epi32(r0, r1); r1 = _mm_max_epi32(r0, r1); r0 = t;
+    t = _mm_min_epi32(r2, r3); r3 = _mm_max_epi32(r2, r3); r2 = t;
+    t = _mm_min_epi32(r0, r2); r2 = _mm_max_epi32(r0, r2); r0 = t;
+    t = _mm_min_epi32(r1, r3); r3 = _mm_max_epi32(r1, r3); r1 = t;
+    t = _mm_min_epi32(r1, r2); r2 = _mm_max_epi32(r1, r2); r1 = t;
+
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1), t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1), t3 = _mm_unpackhi_epi32(r2, r3);
+    __m128i c0 = _mm_unpacklo_epi64(t0, t1), c1 = _mm_unpackhi_epi64(t0, t1);
+    __m128i c2 = _mm_unpacklo_epi64(t2, t3), c3 = _mm_unpackhi_epi64(t2, t3);
+    sse4_merge8(&c0, &c1);
+    sse4_merge8(&c2, &c3);
+
+    __m128i q3 = _mm_shuffle_epi32(c3, 0x1B), q2 = _mm_shuffle_epi32(c2, 0x1B);
+    __m128i l0 = _mm_min_epi32(c0, q3), h0 = _mm_max_epi32(c0, q3);
+    __m128i l1 = _mm_min_epi32(c1, q2), h1 = _mm_max_epi32(c1, q2);
+    _mm_storeu_si128((__m128i*)x, sse4_clean4(_mm_min_epi32(l0, l1)));
+    _mm_storeu_si128((__m128i*)(x + 4), sse4_clean4(_mm_max_epi32(l0, l1)));
+    _mm_storeu_si128((__m128i*)(x + 8), sse4_clean4(_mm_min_epi32(h0, h1)));
+    _mm_storeu_si128((__m128i*)(x + 12), sse4_clean4(_mm_max_epi32(h0, h1)));
+}
+#endif
+
+// -i auto|escalar|sse4|avx2 (auto: o maior que a CPU suporta)
+// retorna 0 se o nome for desconhecido ou a CPU não suportar
+int select_base_kernel(const char *name) {
+    int avx2 = 0, sse4 = 0;
+#ifdef HAVE_SIMD_KERNELS
+    __builtin_cpu_init();
+    avx2 = __builtin_cpu_supports("avx2");
+    sse4 = __builtin_cpu_supports("sse4.1");
+#endif
+    if (strcmp(name, "auto") == 0) {
+        base_kernel = avx2 ? KERNEL_AVX2 : sse4 ? KERNEL_SSE4 : KERNEL_SCALAR;
+    } else if (strcmp(name, "escalar") == 0) {
+        base_kernel = KERNEL_SCALAR;
+    } else if (strcmp(name, "sse4") == 0 && sse4) {
+        base_kernel = KERNEL_SSE4;
+    } else if (strcmp(name, "avx2") == 0 && avx2) {
+        base_kernel = KERNEL_AVX2;
+    } else {
+        return 0;
     }
-    while (i < n1) lista[k++] = left_arr[i++];
-    while (j < n2) lista[k++] = right_arr[j++];
-    
-    free(left_arr);
-    free(right_arr);
+    return 1;
+}
+
+const char *base_kernel_name(void) {
+    switch (base_kernel) {
+    case KERNEL_AVX2: return "avx2, blocos de 32";
+    case KERNEL_SSE4: return "sse4, blocos de 16";
+    default: return "escalar, insertion sort";
+    }
+}
+
+// ordena lista[0..n) em trechos do tamanho da base e devolve esse tamanho;
+// a sobra no fim (menor que um bloco) vai para o insertion sort
+int sort_base_runs(int *lista, int n) {
+    int block = INSERTION_THRESHOLD;
+    int lo = 0;
+#ifdef HAVE_SIMD_KERNELS
+    if (base_kernel == KERNEL_AVX2) {
+        block = 32;
+        for (; lo + 32 <= n; lo += 32) avx2_sort32(lista + lo);
+    } else if (base_kernel == KERNEL_SSE4) {
+        block = 16;
+        for (; lo + 16 <= n; lo += 16) sse4_sort16(lista + lo);
+    }
+#endif
+    for (; lo < n; lo += block) {
+        int hi = lo + block - 1;
+        insertion_sort(lista, lo, hi < n ? hi : n - 1);
+    }
+    return block;
 }
 
+// intercala src[left..mid] e src[mid+1..right] em dst[left..right]
+void merge(const int *src, int *dst, int left, int mid, int right) {
+    int i = left, j = mid + 1, k = left;
+    while (i <= mid && j <= right) {
+        if (src[i] <= src[j]) dst[k++] = src[i++];
+        else dst[k++] = src[j++];
+    }
+    while (i <= mid) dst[k++] = src[i++];
+    while (j <= right) dst[k++] = src[j++];
+}
+
+// Merge sort de baixo para cima, sem recursão e sem alocar: trechos do
+// tamanho da base (sort_base_runs) e depois cada passada intercala pares de
+// trechos dobrando a largura, alternando origem e destino entre lista e aux
+// (n posições). Se o resultado terminar em aux, volta com uma cópia
+void splitsort_buffer(int *lista, int *aux, int n) {
+    int base = sort_base_runs(lista, n);
+    int *src = lista, *dst = aux;
+    for (int width = base; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width - 1;
+            int hi = lo + 2 * width - 1 < n ? lo + 2 * width - 1 : n - 1;
+            if (mid >= hi) memcpy(dst + lo, src + lo, (n - lo) * sizeof(int));
+            else merge(src, dst, lo, mid, hi);
+        }
+        int *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != lista) memcpy(lista, src, n * sizeof(int));
+}
+
+// ordena lista[left..right] com um único vetor auxiliar
 void splitsort(int *lista, int left, int right) {
-    if (right - left + 1 <= INSERTION_THRESHOLD) {
+    int n = right - left + 1;
+    if (n <= INSERTION_THRESHOLD) {
         insertion_sort(lista, left, right);
-    } else {
-        int mid = left + (right - left) / 2;
-        splitsort(lista, left, mid);
-        splitsort(lista, mid + 1, right);
-        merge(lista, left, mid, right);
+        return;
     }
+    int *aux = (int*)malloc(n * sizeof(int));
+    splitsort_buffer(lista + left, aux, n);
+    free(aux);
+}
+
+// Modo híbrido: as duas metades de cada nível da recursão viram tarefas
+// OpenMP até TASK_THRESHOLD; abaixo disso segue o splitsort_buffer. Todas
+// as tarefas dividem o mesmo aux (cada uma na sua faixa) e cada nível
+// intercala de um vetor para o outro: com to_aux o resultado de
+// [left..right] fica em aux, e as metades são ordenadas para o vetor oposto
+void splitsort_task(int *lista, int *aux, int left, int right, int to_aux) {
+    int n = right - left + 1;
+    if (n <= TASK_THRESHOLD) {
+        splitsort_buffer(lista + left, aux + left, n);
+        if (to_aux) memcpy(aux + left, lista + left, n * sizeof(int));
+        return;
+    }
+    int mid = left + (right - left) / 2;
+    #pragma omp task shared(lista, aux)
+    splitsort_task(lista, aux, left, mid, !to_aux);
+    #pragma omp task shared(lista, aux)
+    splitsort_task(lista, aux, mid + 1, right, !to_aux);
+    #pragma omp taskwait
+    if (to_aux) merge(lista, aux, left, mid, right);
+    else merge(aux, lista, left, mid, right);
+}
+
+// um único vetor auxiliar para a ordenação local inteira
+void parallel_local_sort(int *lista, int n) {
+    if (n <= 0) return;
+    int *aux = (int*)malloc(n * sizeof(int));
+    #pragma omp parallel
+    #pragma omp single
+    splitsort_task(lista, aux, 0, n - 1, 0);
+    free(aux);
+}
+
+// sem OpenMP o programa roda com uma thread por processo
+int num_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+// faixa ordenada ainda não consumida, para a intercalação
+typedef struct {
+    const int *pos;
+    const int *end;
+} merge_run;
+
+// a run a sai antes da b? Faixa esgotada perde sempre; empate fica com a
+// de menor índice
+static inline int run_before(const merge_run *runs, int a, int b) {
+    if (runs[b].pos == runs[b].end) return 1;
+    if (runs[a].pos == runs[a].end) return 0;
+    return *runs[a].pos < *runs[b].pos || (*runs[a].pos == *runs[b].pos && a < b);
+}
+
+// Intercala as faixas ordenadas list[0..runs) em dst com uma árvore de
+// perdedores: tree[0] guarda a vencedora e cada nó interno a perdedora do
+// seu jogo. Depois de tirar o elemento da vencedora só o caminho da folha
+// dela até a raiz é rejogado, log2(runs) comparações por elemento
+static void merge_run_list(const merge_run *list, int runs, int *dst) {
+    int leaves = 1;
+    while (leaves < runs) leaves <<= 1;
+    merge_run *run = (merge_run*)malloc(leaves * sizeof(merge_run));
+    int *tree = (int*)malloc(leaves * sizeof(int));
+    int *winner = (int*)malloc(2 * leaves * sizeof(int));
+    long long total = 0;
+    for (int r = 0; r < leaves; r++) {
+        // folhas que sobram são faixas vazias
+        if (r < runs) {
+            run[r] = list[r];
+        } else {
+            run[r].pos = run[r].end = NULL;
+        }
+        winner[leaves + r] = r;
+        total += run[r].end - run[r].pos;
+    }
+    for (int j = leaves - 1; j >= 1; j--) {
+        int a = winner[2 * j], b = winner[2 * j + 1];
+        int a_wins = run_before(run, a, b);
+        winner[j] = a_wins ? a : b;
+        tree[j] = a_wins ? b : a;
+    }
+    tree[0] = winner[1];
+    free(winner);
+    
+    for (long long out = 0; out < total; out++) {
+        int w = tree[0];
+        dst[out] = *run[w].pos++;
+        for (int j = (leaves + w) >> 1; j >= 1; j >>= 1) {
+            if (run_before(run, tree[j], w)) {
+                int loser = w;
+                w = tree[j];
+                tree[j] = loser;
+            }
+        }
+        tree[0] = w;
+    }
+    
+    free(run);
+    free(tree);
+}
+
+// Intercala `runs` faixas ordenadas de src em dst
+void merge_runs(const int *src, const int *counts, const int *displs, int runs, int *dst) {
+    merge_run *list = (merge_run*)malloc((runs > 0 ? runs : 1) * sizeof(merge_run));
+    for (int r = 0; r < runs; r++) {
+        list[r].pos = src + displs[r];
+        list[r].end = list[r].pos + counts[r];
+    }
+    merge_run_list(list, runs, dst);
+    free(list);
+}
+
+// faixa já intercalada à espera de outra do mesmo nível (contador binário:
+// duas faixas de nível l viram uma de nível l+1, total O(n log p))
+typedef struct {
+    merge_run run;
+    int level;
+    int *owned;  // buffer próprio, ou NULL se aponta para a recepção
+} pending_run;
+
+// empilha uma faixa completa, intercalando com o topo enquanto os níveis
+// coincidirem
+static void push_run(pending_run *stack, int *top, const int *data, int count) {
+    if (count == 0) return;
+    pending_run item = {{data, data + count}, 0, NULL};
+    while (*top > 0 && stack[*top - 1].level == item.level) {
+        pending_run *below = &stack[--*top];
+        merge_run pair[2] = {below->run, item.run};
+        long long total = (pair[0].end - pair[0].pos) + (pair[1].end - pair[1].pos);
+        int *buffer = (int*)malloc(total * sizeof(int));
+        merge_run_list(pair, 2, buffer);
+        free(below->owned);
+        free(item.owned);
+        item.run.pos = buffer;
+        item.run.end = buffer + total;
+        item.level++;
+        item.owned = buffer;
+    }
+    stack[(*top)++] = item;
+}
+
+// Redistribuição em pedaços de EXCHANGE_CHUNK elementos com MPI_Isend/
+// MPI_Irecv, intercalando as faixas conforme chegam. Cada faixa completa
+// entra numa pilha de níveis e é intercalada com a do topo enquanto os
+// níveis coincidirem, então o trabalho de intercalação acontece com o resto
+// ainda em trânsito; no fim, as poucas faixas da pilha (no máximo
+// log2(p) + 1) vão para dst numa árvore de perdedores
+void exchange_and_merge(const int *send, const int *send_counts, const int *send_displs,
+                        const int *recv_counts, const int *recv_displs, int *dst, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    
+    int total_recv = recv_displs[size - 1] + recv_counts[size - 1];
+    int *recv = (int*)malloc((total_recv > 0 ? total_recv : 1) * sizeof(int));
+    
+    int num_recv = 0, num_send = 0;
+    for (int p = 0; p < size; p++) {
+        if (p == rank) continue;
+        num_recv += (recv_counts[p] + EXCHANGE_CHUNK - 1) / EXCHANGE_CHUNK;
+        num_send += (send_counts[p] + EXCHANGE_CHUNK - 1) / EXCHANGE_CHUNK;
+    }
+    MPI_Request *recv_req = (MPI_Request*)malloc((num_recv > 0 ? num_recv : 1) * sizeof(MPI_Request));
+    MPI_Request *send_req = (MPI_Request*)malloc((num_send > 0 ? num_send : 1) * sizeof(MPI_Request));
+    int *recv_source = (int*)malloc((num_recv > 0 ? num_recv : 1) * sizeof(int));
+    int *chunks_left = (int*)calloc(size, sizeof(int));
+    
+    // recepções primeiro; envios começam pelo vizinho seguinte para não
+    // caírem todos no mesmo processo ao mesmo tempo
+    int r = 0;
+    for (int step = 1; step < size; step++) {
+        int p = (rank - step + size) % size;
+        for (int off = 0; off < recv_counts[p]; off += EXCHANGE_CHUNK) {
+            int chunk = recv_counts[p] - off < EXCHANGE_CHUNK ? recv_counts[p] - off : EXCHANGE_CHUNK;
+            MPI_Irecv(recv + recv_displs[p] + off, chunk, MPI_INT, p, 0, comm, &recv_req[r]);
+            recv_source[r++] = p;
+            chunks_left[p]++;
+        }
+    }
+    int s = 0;
+    for (int step = 1; step < size; step++) {
+        int p = (rank + step) % size;
+        for (int off = 0; off < send_counts[p]; off += EXCHANGE_CHUNK) {
+            int chunk = send_counts[p] - off < EXCHANGE_CHUNK ? send_counts[p] - off : EXCHANGE_CHUNK;
+            MPI_Isend(send + send_displs[p] + off, chunk, MPI_INT, p, 0, comm, &send_req[s++]);
+        }
+    }
+    
+    // a faixa do próprio processo já está pronta, direto do envio; as outras
+    // entram quando o último pedaço delas chega
+    pending_run *stack = (pending_run*)malloc((size + 1) * sizeof(pending_run));
+    int top = 0;
+    push_run(stack, &top, send + send_displs[rank], send_counts[rank]);
+    for (int arrived = 0; arrived < num_recv; arrived++) {
+        int done;
+        MPI_Waitany(num_recv, recv_req, &done, MPI_STATUS_IGNORE);
+        int p = recv_source[done];
+        if (--chunks_left[p] == 0) push_run(stack, &top, recv + recv_displs[p], recv_counts[p]);
+    }
+    
+    merge_run *list = (merge_run*)calloc(top > 0 ? top : 1, sizeof(merge_run));
+    for (int i = 0; i < top; i++) list[i] = stack[i].run;
+    merge_run_list(list, top, dst);
+    for (int i = 0; i < top; i++) free(stack[i].owned);
+    MPI_Waitall(num_send, send_req, MPI_STATUSES_IGNORE);
+    
+    free(list);
+    free(stack);
+    free(recv);
+    free(recv_req);
+    free(send_req);
+    free(recv_source);
+    free(chunks_left);
 }
 
 void imprime(int *lista, int size, int rank) {
+    if (quiet || size > PRINT_LIMIT) {
+        printf("P%d: [%d elementos]\n", rank, size);
+        return;
+    }
     printf("P%d: [", rank);
     for (int i = 0; i < size; i++) {
         printf("%d", lista[i]);
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 // valores entre 10-20 geralmente sao otimos
@@ -8,18 +9,12 @@
 
 // Protótipos das funções
 void insertion_sort(int *lista, int left, int right);
-void merge(int *lista, int left, int mid, int right);
-void splitsort(int *lista, int left, int right);
+void merge(const int *src, int *dst, int left, int mid, int right);
+void splitsort_buffer(int *lista, int *aux, int n);
 void imprime(int *lista, int size);
+void counting_sort(int *arr, int n, int min_val, int intervalo);
 void bucket_sort(int *arr, int n, int num_baldes);
 
-// Estrutura para representar um balde
-typedef struct {
-    int *elementos;
-    int tamanho;
-    int capacidade;
-} Balde;
-
 int main() {
     // Teste com o bucket sort
     printf("=== TESTE COM BUCKET SORT ===\n");
@@ -58,71 +53,39 @@ void insertion_sort(int *lista, int esq, int dir) {
     }
 }
 
-// merge dos dois vetores ordenados
-void merge(int *lista, int esq, int meio, int dir){
-    int n1 = meio - esq + 1;
-    int n2 = dir - meio;
-
-    // cria vetores temporarios
-    int *lista_esq = (int*) malloc(n1 * sizeof(int));
-    int *lista_dir = (int*) malloc(n2 * sizeof(int));
-
-    // copia os dados para essas listas temporarias
-    for(int i = 0; i < n1; i++){
-        lista_esq[i] = lista[esq + i];
+// intercala src[left..mid] e src[mid+1..right] em dst[left..right]
+void merge(const int *src, int *dst, int left, int mid, int right) {
+    int i = left, j = mid + 1, k = left;
+    while (i <= mid && j <= right) {
+        if (src[i] <= src[j]) dst[k++] = src[i++];
+        else dst[k++] = src[j++];
     }
-    for(int i = 0; i < n2; i++){
-        lista_dir[i] = lista[meio + 1 + i];
-    }
-
-    // merge dos vetores temporarios de volta para o vetor original
-    int i = 0, j = 0, k = esq;
-
-    while(i < n1 && j < n2){
-        if(lista_esq[i] <= lista_dir[j]){
-            lista[k] = lista_esq[i];
-            i++;
-        }else{
-            lista[k] = lista_dir[j];
-            j++;
-        }
-        k++;
-    }
-
-    // copia os elementos restantes da parte esquerda, se houver
-    while (i < n1) {
-        lista[k] = lista_esq[i];
-        i++;
-        k++;
-    }
-    
-    // copia os elementos restantes da parte direita, se houver
-    while (j < n2) {
-        lista[k] = lista_dir[j];
-        j++;
-        k++;
-    }
-    
-    free(lista_esq);
-    free(lista_dir);
+    while (i <= mid) dst[k++] = src[i++];
+    while (j <= right) dst[k++] = src[j++];
 }
 
-// funcao principal do split sort
-void splitsort(int *lista, int left, int right) {
-    // se o subvetor for pequeno, usa o insertion
-    if (right - left + 1 <= INSERTION_THRESHOLD) {
-        insertion_sort(lista, left, right);
-    } else {
-        // divide recursivamente
-        int mid = left + (right - left) / 2;
-        
-        // ordena a 1° e a 2° metade
-        splitsort(lista, left, mid);
-        splitsort(lista, mid + 1, right);
-        
-        // faz o merge das partes ordenadas
-        merge(lista, left, mid, right);
+// Merge sort de baixo para cima, sem recursão e sem alocar: trechos de
+// INSERTION_THRESHOLD vão para o insertion e depois cada passada intercala
+// pares de trechos dobrando a largura, alternando origem e destino entre
+// lista e aux (n posições). Se o resultado terminar em aux, volta com uma cópia
+void splitsort_buffer(int *lista, int *aux, int n) {
+    for (int lo = 0; lo < n; lo += INSERTION_THRESHOLD) {
+        int hi = lo + INSERTION_THRESHOLD - 1;
+        insertion_sort(lista, lo, hi < n ? hi : n - 1);
+    }
+    int *src = lista, *dst = aux;
+    for (int width = INSERTION_THRESHOLD; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width - 1;
+            int hi = lo + 2 * width - 1 < n ? lo + 2 * width - 1 : n - 1;
+            if (mid >= hi) memcpy(dst + lo, src + lo, (n - lo) * sizeof(int));
+            else merge(src, dst, lo, mid, hi);
+        }
+        int *tmp = src;
+        src = dst;
+        dst = tmp;
     }
+    if (src != lista) memcpy(lista, src, n * sizeof(int));
 }
 
 void imprime(int *lista, int size) {
@@ -132,30 +95,27 @@ void imprime(int *lista, int size) {
     printf("\n");
 }
 
-// Função para criar um balde
-Balde* criar_balde() {
-    Balde *b = (Balde*) malloc(sizeof(Balde));
-    b->capacidade = 10;
-    b->tamanho = 0;
-    b->elementos = (int*) malloc(b->capacidade * sizeof(int));
-    return b;
-}
-
-// add um elemento a um balde
-void adicionar_ao_balde(Balde *b, int elemento) {
-    if (b->tamanho == b->capacidade) {
-        b->capacidade *= 2;
-        b->elementos = (int*) realloc(b->elementos, b->capacidade * sizeof(int));
+// contagem direta: um contador por valor em [min_val, min_val + intervalo)
+// e os valores reescritos em ordem, sem comparacoes
+void counting_sort(int *arr, int n, int min_val, int intervalo) {
+    int *contagem = (int*) calloc(intervalo, sizeof(int));
+    for (int i = 0; i < n; i++) {
+        contagem[arr[i] - min_val]++;
     }
-    b->elementos[b->tamanho++] = elemento;
-}
-
-void liberar_balde(Balde *b) {
-    free(b->elementos);
-    free(b);
+    int k = 0;
+    for (int v = 0; v < intervalo; v++) {
+        for (int c = 0; c < contagem[v]; c++) {
+            arr[k++] = min_val + v;
+        }
+    }
+    free(contagem);
 }
 
-
+// Baldes em duas passadas sobre um unico vetor de saida: a primeira conta
+// quantos elementos caem em cada balde, a soma de prefixo vira o inicio de
+// cada balde e a segunda escreve cada elemento na proxima posicao do seu.
+// Sao tres alocacoes por chamada (balde, inicio e saida), nenhuma por
+// balde e nenhum realloc
 void bucket_sort(int *arr, int n, int num_baldes) {
     if (n <= 0) return;
     
@@ -168,36 +128,56 @@ void bucket_sort(int *arr, int n, int num_baldes) {
         if (arr[i] > max_val) max_val = arr[i];
     }
     
+    // poucos valores distintos possiveis (no maximo n): contagem direta
+    long long intervalo_total = (long long)max_val - min_val + 1;
+    if (intervalo_total <= n) {
+        counting_sort(arr, n, min_val, (int)intervalo_total);
+        return;
+    }
+    
     // calcula o intervalo de cada balde
-    double intervalo = (double)(max_val - min_val + 1) / num_baldes;
+    double intervalo = (double)intervalo_total / num_baldes;
+    
+    // 1a passada: balde de cada elemento e tamanho de cada balde
+    int *balde = (int*) malloc(n * sizeof(int));
+    int *inicio = (int*) calloc(num_baldes + 1, sizeof(int));
+    for (int i = 0; i < n; i++) {
+        int index = (int)(((long long)arr[i] - min_val) / intervalo);
+        if (index == num_baldes) index--;
+        balde[i] = index;
+        inicio[index + 1]++;
+    }
     
-    // cria os baldes
-    Balde **baldes = (Balde**) malloc(num_baldes * sizeof(Balde*));
-    for (int i = 0; i < num_baldes; i++) {
-        baldes[i] = criar_balde();
+    // soma de prefixo: o balde b ocupa [inicio[b], inicio[b + 1])
+    for (int b = 0; b < num_baldes; b++) {
+        inicio[b + 1] += inicio[b];
     }
     
-    // distribui os elementos no baldes
+    // 2a passada: espalha no vetor de saida, mantendo a ordem dentro do balde
+    // inicio[b] avanca a cada escrita e termina no fim do balde, que e o
+    // inicio do seguinte: deslocar uma posicao refaz os inicios
+    int *saida = (int*) malloc(n * sizeof(int));
     for (int i = 0; i < n; i++) {
-        int index = (int)((arr[i] - min_val) / intervalo);
-        if (index == num_baldes) index--; // 
-        adicionar_ao_balde(baldes[index], arr[i]);
+        saida[inicio[balde[i]]++] = arr[i];
     }
+    for (int b = num_baldes; b > 0; b--) {
+        inicio[b] = inicio[b - 1];
+    }
+    inicio[0] = 0;
     
-    // ordena cada balde usando o splitsort
-    int index = 0;
-    for (int i = 0; i < num_baldes; i++) {
-        if (baldes[i]->tamanho > 0) {
-
-            splitsort(baldes[i]->elementos, 0, baldes[i]->tamanho - 1);
-            
-            // copia os valores para o dado original
-            for (int j = 0; j < baldes[i]->tamanho; j++) {
-                arr[index++] = baldes[i]->elementos[j];
-            }
+    // ordena cada balde no lugar; arr ja foi todo copiado para a saida e
+    // serve de vetor auxiliar do merge sort, na mesma faixa do balde
+    for (int b = 0; b < num_baldes; b++) {
+        int tamanho = inicio[b + 1] - inicio[b];
+        if (tamanho > 1) {
+            splitsort_buffer(saida + inicio[b], arr + inicio[b], tamanho);
         }
-        liberar_balde(baldes[i]);
     }
     
-    free(baldes);
-}
\ No newline at end of file
+    // os baldes ja estao em ordem no vetor de saida: uma copia so
+    memcpy(arr, saida, n * sizeof(int));
+    
+    free(balde);
+    free(inicio);
+    free(saida);
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 // valores entre 10-20 geralmente sao otimos
@@ -7,7 +8,8 @@
 
 
 void insertion_sort(int *lista, int left, int right);
-void merge(int *lista, int left, int mid, int right);
+void merge(const int *src, int *dst, int left, int mid, int right);
+void splitsort_buffer(int *lista, int *aux, int n);
 void splitsort(int *lista, int left, int right);
 void imprime(int *lista, int size);
 
@@ -59,73 +61,54 @@ void insertion_sort(int *lista, int esq, int dir) {
     }
 }
 
-// merge dos dois vetores ordenados
-void merge(int *lista, int esq, int meio, int dir){
-    int n1 = meio - esq + 1;
-    int n2 = dir - meio;
-
-    // cria vetores temporarios
-    int *lista_dir = (int*) malloc(n1*sizeof(int));
-    int *lista_esq = (int*) malloc(n2*sizeof(int));
-
-    // copia os dados para essas listas temporarias
-    for(int i = 0; i < n1; i++){
-        lista_esq[i] = lista[esq+i];
-    }
-    for(int i = 0; i < n2; i++){
-        lista_dir[i] = lista[meio + 1 + i];
-    }
-
-    // merge dos vetores temporarios de volta para o vetor original
-    int i = 0, j = 0, k = esq;
-
-    while(i < n1 && j < n2){
-        if(lista_esq[i] <= lista_dir[j]){
-            lista[k] = lista_esq[i];
-            i++;
-        }else{
-            lista[k] = lista_dir[j];
-            j++;
-        }
-        k++;
+// intercala src[left..mid] e src[mid+1..right] em dst[left..right]
+void merge(const int *src, int *dst, int left, int mid, int right) {
+    int i = left, j = mid + 1, k = left;
+    while (i <= mid && j <= right) {
+        if (src[i] <= src[j]) dst[k++] = src[i++];
+        else dst[k++] = src[j++];
     }
+    while (i <= mid) dst[k++] = src[i++];
+    while (j <= right) dst[k++] = src[j++];
+}
 
-    // copia os elementos restantes da parte esquerda, se houver
-    while (i < n1) {
-        lista[k] = lista_esq[i];
-        i++;
-        k++;
+// Merge sort de baixo para cima, sem recursão e sem alocar: trechos de
+// INSERTION_THRESHOLD vão para o insertion e depois cada passada intercala
+// pares de trechos dobrando a largura, alternando origem e destino entre
+// lista e aux (n posições). Se o resultado terminar em aux, volta com uma cópia
+void splitsort_buffer(int *lista, int *aux, int n) {
+    for (int lo = 0; lo < n; lo += INSERTION_THRESHOLD) {
+        int hi = lo + INSERTION_THRESHOLD - 1;
+        insertion_sort(lista, lo, hi < n ? hi : n - 1);
     }
-    
-    // copia os elementos restantes da parte direita, se houver
-    while (j < n2) {
-        lista[k] = lista_dir[j];
-        j++;
-        k++;
+    int *src = lista, *dst = aux;
+    for (int width = INSERTION_THRESHOLD; width < n; width *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width - 1;
+            int hi = lo + 2 * width - 1 < n ? lo + 2 * width - 1 : n - 1;
+            if (mid >= hi) memcpy(dst + lo, src + lo, (n - lo) * sizeof(int));
+            else merge(src, dst, lo, mid, hi);
+        }
+        int *tmp = src;
+        src = dst;
+        dst = tmp;
     }
-    
-    free(lista_esq);
-    free(lista_dir);
+    if (src != lista) memcpy(lista, src, n * sizeof(int));
 }
 
-// funcao principal do split sort
+// ordena lista[left..right] com um único vetor auxiliar
 void splitsort(int *lista, int left, int right) {
-    // se o subvetor for pequeno, usa o insertion
-    if (right - left + 1 <= INSERTION_THRESHOLD) {
+    int n = right - left + 1;
+    if (n <= INSERTION_THRESHOLD) {
         insertion_sort(lista, left, right);
-    } else {
-        // divide recursivamente
-        int mid = left + (right - left) / 2;
-        
-        // ordena a 1° e a 2° metade
-        splitsort(lista, left, mid);
-        splitsort(lista, mid + 1, right);
-        
-        // faz o merge das partes ordenadas
-        merge(lista, left, mid, right);
+        return;
     }
+    int *aux = (int*)malloc(n * sizeof(int));
+    splitsort_buffer(lista + left, aux, n);
+    free(aux);
 }
 
+
 void imprime(int *lista, int size) {
     for (int i = 0; i < size; i++) {
         printf("%d ", lista[i]);
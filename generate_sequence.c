@@ -1,32 +1,157 @@
 // gerar_dados.c
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
-void generate_dna_sequence(char *buffer, int length) {
+// sequencias por bloco; cada bloco tem a sua semente e vira uma escrita so
+#define BLOCK_SEQS 65536
+// maior sequencia que cabe num registro do formato binario
+#define DNA_KEY_MAX_BASES 60
+
+// sequencia empacotada com 2 bits por base (A=0, C=1, G=2, T=3), bases a
+// partir do bit mais alto de w[0]; os 8 bits finais de w[1] guardam o
+// comprimento (mesmo dna_key dos ordenadores)
+typedef struct {
+  uint64_t w[2];
+} dna_key;
+
+// Arquivo binario: cabecalho de 32 bytes e depois os registros, cada um um
+// dna_key de 16 bytes como fica na memoria (w[0], w[1], little-endian).
+// O registro i comeca em sizeof(dna_bin_header) + i * sizeof(dna_key)
+#define DNA_BIN_MAGIC "DNA2BIT"
+#define DNA_BIN_VERSION 1
+#define DNA_BIN_ENCODING_2BIT 1
+
+typedef struct {
+  char magic[8];        // "DNA2BIT\0"
+  uint32_t version;     // DNA_BIN_VERSION
+  uint32_t encoding;    // DNA_BIN_ENCODING_2BIT
+  uint64_t count;       // numero de registros
+  uint32_t seq_length;  // comprimento comum das sequencias, 0 se variar
+  uint32_t record_size; // sizeof(dna_key)
+} dna_bin_header;
+
+// 4 bases por byte aleatorio (2 bits cada)
+static char base_table[256][4];
+
+static void init_base_table(void) {
   const char nucleotides[] = "ACGT";
-  for (int i = 0; i < length; i++) {
-    buffer[i] = nucleotides[rand() % 4];
+  for (int b = 0; b < 256; b++) {
+    for (int k = 0; k < 4; k++) {
+      base_table[b][k] = nucleotides[(b >> (2 * k)) & 3];
+    }
+  }
+}
+
+// splitmix64: gerador baseado em contador; o estado so soma a constante,
+// entao qualquer ponto da sequencia sai direto de (semente, posicao)
+static inline uint64_t splitmix64(uint64_t *state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Gera o bloco `block` (linhas de comprimento length + 1) em buffer. O
+// estado do bloco depende so da semente e do indice do bloco, entao o
+// arquivo sai igual byte a byte com qualquer numero de threads
+static void generate_block(char *buffer, long long block, int seqs, int length,
+                           uint64_t seed) {
+  uint64_t state = seed ^ (uint64_t)block * 0xd1b54a32d192ed03ULL;
+  state = splitmix64(&state);
+  char *out = buffer;
+  for (int s = 0; s < seqs; s++) {
+    int i = 0;
+    // 32 bases por palavra de 64 bits, 4 por consulta na tabela
+    for (; i + 32 <= length; i += 32) {
+      uint64_t word = splitmix64(&state);
+      for (int b = 0; b < 8; b++) {
+        memcpy(out + i + 4 * b, base_table[(word >> (8 * b)) & 0xff], 4);
+      }
+    }
+    if (i < length) {
+      uint64_t word = splitmix64(&state);
+      for (; i < length; i++) {
+        out[i] = "ACGT"[word & 3];
+        word >>= 2;
+      }
+    }
+    out[length] = '\n';
+    out += length + 1;
+  }
+}
+
+// empacota as seqs linhas de texto do bloco (comprimento length + 1) em
+// keys; as sequencias sao as mesmas da saida em texto
+static void pack_block(const char *text, dna_key *keys, int seqs, int length) {
+  for (int s = 0; s < seqs; s++) {
+    const char *seq = text + (long long)s * (length + 1);
+    keys[s].w[0] = keys[s].w[1] = 0;
+    for (int i = 0; i < length; i++) {
+      // A=0, C=1, G=2, T=3 a partir dos bits 1 e 2 do ASCII
+      uint64_t code = ((seq[i] >> 1) ^ (seq[i] >> 2)) & 3;
+      keys[s].w[i / 32] |= code << (62 - 2 * (i % 32));
+    }
+    keys[s].w[1] |= (uint64_t)length;
   }
-  buffer[length] = '\0';
 }
 
 int main(int argc, char *argv[]) {
-  if (argc != 3) {
-    printf("Uso: %s <num_sequencias> <arquivo_saida>\n", argv[0]);
+  // -t N: threads de geracao (so muda a velocidade, nunca o conteudo)
+  // -f binario: registros empacotados de 16 bytes em vez de linhas de texto
+  int opt;
+  int usage = 0;
+  int binary = 0;
+  while ((opt = getopt(argc, argv, "t:f:")) != -1) {
+    if (opt == 't' && atoi(optarg) > 0) {
+#ifdef _OPENMP
+      omp_set_num_threads(atoi(optarg));
+#endif
+    } else if (opt == 'f' && strcmp(optarg, "texto") == 0) {
+      binary = 0;
+    } else if (opt == 'f' && strcmp(optarg, "binario") == 0) {
+      binary = 1;
+    } else {
+      usage = 1;
+    }
+  }
+  int positional = argc - optind;
+  if (usage || positional < 2 || positional > 4) {
+    printf("Uso: %s [-t threads] [-f texto|binario] <num_sequencias> <arquivo_saida> [comprimento] "
+           "[semente]\n",
+           argv[0]);
     return 1;
   }
 
-  int num_seqs = atoi(argv[1]);
-  const char *filename = argv[2];
-  int seq_length = 50; // comprimento fixo das sequencias
+  long long num_seqs = atoll(argv[optind]);
+  const char *filename = argv[optind + 1];
+  // comprimento fixo das sequencias (padrao 50)
+  int seq_length = positional > 2 ? atoi(argv[optind + 2]) : 50;
   const char *input_dir = "input";
   char outpath[4096];
 
-  srand(time(NULL));
+  if (seq_length < 1 || num_seqs < 0) {
+    printf("Comprimento deve ser positivo\n");
+    return 1;
+  }
+  if (binary && seq_length > DNA_KEY_MAX_BASES) {
+    printf("O formato binario aceita ate %d bases\n", DNA_KEY_MAX_BASES);
+    return 1;
+  }
+
+  // com semente a entrada e reprodutivel (medicoes); sem ela, varia
+  uint64_t seed = positional > 3 ? strtoull(argv[optind + 3], NULL, 10)
+                                 : (uint64_t)time(NULL);
 
   // certifica que o caminho de saida esteja dentro de input
   if (strncmp(filename, "input/", 6) == 0) {
@@ -35,20 +160,93 @@ int main(int argc, char *argv[]) {
     snprintf(outpath, sizeof(outpath), "%s/%s", input_dir, filename);
   }
 
-  FILE *file = fopen(outpath, "w");
-  if (!file) {
+  int fd = open(outpath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
     perror("Erro ao criar arquivo");
     return 1;
   }
 
-  char buffer[seq_length + 1];
-  for (int i = 0; i < num_seqs; i++) {
-    generate_dna_sequence(buffer, seq_length);
-    fprintf(file, "%s\n", buffer);
+  // todo registro tem o mesmo tamanho (a linha com o '\n', ou a chave de
+  // 16 bytes depois do cabecalho), entao o bloco b comeca em
+  // header + b * BLOCK_SEQS * record e cada thread grava o seu com pwrite
+  long long line = seq_length + 1;
+  long long record = binary ? (long long)sizeof(dna_key) : line;
+  off_t header = 0;
+  if (binary) {
+    dna_bin_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, DNA_BIN_MAGIC, sizeof(DNA_BIN_MAGIC));
+    h.version = DNA_BIN_VERSION;
+    h.encoding = DNA_BIN_ENCODING_2BIT;
+    h.count = (uint64_t)num_seqs;
+    h.seq_length = (uint32_t)seq_length;
+    h.record_size = sizeof(dna_key);
+    if (pwrite(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+      perror("Erro ao escrever arquivo");
+      close(fd);
+      return 1;
+    }
+    header = sizeof(h);
+  }
+  if (ftruncate(fd, header + num_seqs * record) != 0) {
+    perror("Erro ao reservar o arquivo");
+    close(fd);
+    return 1;
+  }
+  init_base_table();
+  long long num_blocks = (num_seqs + BLOCK_SEQS - 1) / BLOCK_SEQS;
+  // erro da primeira falha (alocacao ou pwrite), guardado na hora: depois
+  // da regiao paralela o errno pode ser de outra chamada
+  int error = 0;
+
+#pragma omp parallel
+  {
+    char *buffer = malloc(BLOCK_SEQS * line);
+    dna_key *keys = binary ? malloc(BLOCK_SEQS * sizeof(dna_key)) : NULL;
+    int ready = buffer && (!binary || keys);
+    if (!ready) {
+#pragma omp atomic write
+      error = ENOMEM;
+    }
+#pragma omp for schedule(dynamic)
+    for (long long b = 0; b < num_blocks; b++) {
+      // sem buffers esta thread nao gera nada; o arquivo fica incompleto
+      // e o erro ja esta registrado
+      if (!ready)
+        continue;
+      int seqs = num_seqs - b * BLOCK_SEQS < BLOCK_SEQS
+                     ? (int)(num_seqs - b * BLOCK_SEQS)
+                     : BLOCK_SEQS;
+      generate_block(buffer, b, seqs, seq_length, seed);
+      const char *out = buffer;
+      if (binary) {
+        pack_block(buffer, keys, seqs, seq_length);
+        out = (const char *)keys;
+      }
+      size_t bytes = seqs * record;
+      off_t offset = header + b * BLOCK_SEQS * record;
+      size_t done = 0;
+      while (done < bytes) {
+        ssize_t w = pwrite(fd, out + done, bytes - done, offset + done);
+        if (w <= 0) {
+          // w == 0 nao define errno
+#pragma omp atomic write
+          error = w < 0 ? errno : EIO;
+          break;
+        }
+        done += w;
+      }
+    }
+    free(keys);
+    free(buffer);
   }
 
-  fclose(file);
-  printf("Geradas %d sequencias em %s\n", num_seqs, outpath);
+  close(fd);
+  if (error) {
+    fprintf(stderr, "Erro ao escrever arquivo: %s\n", strerror(error));
+    return 1;
+  }
+  printf("Geradas %lld sequencias em %s\n", num_seqs, outpath);
 
   return 0;
-}
\ No newline at end of file
+}
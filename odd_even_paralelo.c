@@ -1,9 +1,171 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <mpi.h>
 
 #define DNA_CHARS "ACGT"
+// 32 bases na palavra 0 + 28 na palavra 1; os 8 bits finais guardam o comprimento
+#define DNA_KEY_MAX_BASES 60
+// alinhamento do bloco de registros (linha de cache)
+#define ARENA_ALIGNMENT 64
+// maior escrita MPI-IO por chamada (o count é int)
+#define MPIIO_CHUNK (1 << 30)
+
+// sequencia empacotada com 2 bits por base (A=0, C=1, G=2, T=3)
+// a comparacao de (w[0], w[1]) como inteiros sem sinal equivale ao strcmp
+typedef struct {
+    uint64_t w[2];
+} dna_key;
+
+// Arquivo binário (-f binario): cabeçalho de 32 bytes e depois os registros,
+// cada um um dna_key de 16 bytes como fica na memória (w[0], w[1],
+// little-endian); o registro i começa em sizeof(dna_bin_header) + 16 * i
+#define DNA_BIN_MAGIC "DNA2BIT"
+#define DNA_BIN_VERSION 1
+#define DNA_BIN_ENCODING_2BIT 1
+
+typedef struct {
+    char magic[8];         // "DNA2BIT\0"
+    uint32_t version;      // DNA_BIN_VERSION
+    uint32_t encoding;     // DNA_BIN_ENCODING_2BIT
+    uint64_t count;        // número de registros
+    uint32_t seq_length;   // comprimento comum das sequências, 0 se variar
+    uint32_t record_size;  // sizeof(dna_key)
+} dna_bin_header;
+
+// entrada gerada (-d)
+enum { INPUT_RANDOM, INPUT_SORTED, INPUT_NEARLY_SORTED };
+
+// bloco contiguo e alinhado com todos os registros de um rank
+// e enviado e recebido direto pelo MPI, sem empacotar elemento a elemento
+typedef struct {
+    dna_key* keys;
+    int count;
+    int capacity;
+} dna_arena;
+
+// buffers do compare-separa, alocados uma vez e reaproveitados em todas as fases
+typedef struct {
+    dna_arena partner;  // bloco recebido do parceiro
+    dna_arena kept;     // metade mantida; trocada com o bloco local ao fim
+} split_workspace;
+
+// extremo do bloco trocado antes dos dados: o maior para quem fica com os
+// menores, o menor para quem fica com os maiores
+typedef struct {
+    dna_key key;
+    int size;
+} block_edge;
+
+// Linha do tempo (-T arquivo): cada rank registra início e fim de cada etapa,
+// com os bytes enviados e recebidos nela; no fim o processo 0 junta tudo num
+// JSON de eventos do Chrome (chrome://tracing ou ui.perfetto.dev), com um
+// "processo" por rank. Desligada, trace_begin devolve -1 e nada é registrado
+#define TRACE_NAME_LENGTH 32
+
+typedef struct {
+    char name[TRACE_NAME_LENGTH];
+    double start;
+    double end;
+    long long sent;
+    long long received;
+} trace_event;
+
+static trace_event* trace_events = NULL;
+static int trace_count = 0;
+static int trace_capacity = 0;
+static double trace_origin = 0;
+
+// liga a linha do tempo; o instante zero é a saída de uma barreira, então os
+// ranks ficam alinhados mesmo sem relógio global
+void trace_enable(MPI_Comm comm) {
+    trace_capacity = 64;
+    trace_events = malloc(trace_capacity * sizeof(trace_event));
+    MPI_Barrier(comm);
+    trace_origin = MPI_Wtime();
+}
+
+int trace_begin(const char* name) {
+    if (!trace_events) return -1;
+    if (trace_count == trace_capacity) {
+        trace_capacity *= 2;
+        trace_events = realloc(trace_events, trace_capacity * sizeof(trace_event));
+    }
+    trace_event* e = &trace_events[trace_count];
+    snprintf(e->name, TRACE_NAME_LENGTH, "%s", name);
+    e->start = e->end = MPI_Wtime() - trace_origin;
+    e->sent = e->received = 0;
+    return trace_count++;
+}
+
+void trace_end(int id, long long sent, long long received) {
+    if (id < 0) return;
+    trace_events[id].end = MPI_Wtime() - trace_origin;
+    trace_events[id].sent = sent;
+    trace_events[id].received = received;
+}
+
+// Coletiva: cada rank formata os seus eventos ("X", tempos em µs) e o
+// processo 0 recebe os textos com um Gatherv e grava o arquivo
+void trace_write(const char* filename, MPI_Comm comm) {
+    if (!trace_events) return;
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int capacity = (trace_count + 1) * 256;
+    char* text = malloc(capacity);
+    int length = snprintf(text, capacity,
+                          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                          "\"args\":{\"name\":\"rank %d\"}},\n", rank, rank);
+    for (int i = 0; i < trace_count; i++) {
+        const trace_event* e = &trace_events[i];
+        length += snprintf(text + length, capacity - length,
+                           "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":0,"
+                           "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes_enviados\":%lld,"
+                           "\"bytes_recebidos\":%lld}},\n",
+                           e->name, rank, e->start * 1e6, (e->end - e->start) * 1e6,
+                           e->sent, e->received);
+    }
+
+    int* lengths = NULL;
+    int* displs = NULL;
+    char* all = NULL;
+    if (rank == 0) lengths = malloc(size * sizeof(int));
+    MPI_Gather(&length, 1, MPI_INT, lengths, 1, MPI_INT, 0, comm);
+    int total = 0;
+    if (rank == 0) {
+        displs = malloc(size * sizeof(int));
+        for (int p = 0; p < size; p++) {
+            displs[p] = total;
+            total += lengths[p];
+        }
+        all = malloc(total);
+    }
+    MPI_Gatherv(text, length, MPI_CHAR, all, lengths, displs, MPI_CHAR, 0, comm);
+
+    if (rank == 0) {
+        FILE* out = fopen(filename, "w");
+        if (out) {
+            // o último evento termina em ",\n"; a vírgula sai antes do "]"
+            fprintf(out, "{\"traceEvents\":[\n");
+            fwrite(all, 1, total - 2, out);
+            fprintf(out, "\n]}\n");
+            fclose(out);
+        } else {
+            fprintf(stderr, "Erro ao criar arquivo %s\n", filename);
+        }
+        free(lengths);
+        free(displs);
+        free(all);
+    }
+    free(text);
+    free(trace_events);
+    trace_events = NULL;
+    trace_count = trace_capacity = 0;
+}
 
 // Funções auxiliares
 void generate_dna_sequence(char* seq, int length) {
@@ -13,135 +175,426 @@ void generate_dna_sequence(char* seq, int length) {
     seq[length] = '\0';
 }
 
+// Sequência de posição v na ordem: v em base 4 nas últimas bases, 'A' antes.
+// Se v não couber em length bases fica a maior (as últimas empatam), então
+// v crescente sempre dá sequências em ordem não decrescente
+void generate_ordered_sequence(char* seq, int length, long long v) {
+    for (int i = length - 1; i >= 0; i--) {
+        seq[i] = DNA_CHARS[v % 4];
+        v /= 4;
+    }
+    if (v > 0) {
+        memset(seq, 'T', length);
+    }
+    seq[length] = '\0';
+}
+
+static inline int dna_base_code(char c) {
+    switch (c) {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+    }
+    return -1;
+}
+
+// empacota a sequencia; retorna 0 se ela nao couber na chave
+int dna_pack(const char* seq, dna_key* key) {
+    key->w[0] = key->w[1] = 0;
+    int i;
+    for (i = 0; seq[i] != '\0'; i++) {
+        int code = dna_base_code(seq[i]);
+        if (code < 0 || i >= DNA_KEY_MAX_BASES) return 0;
+        key->w[i / 32] |= (uint64_t)code << (62 - 2 * (i % 32));
+    }
+    key->w[1] |= (uint64_t)i;
+    return 1;
+}
+
+// número de bases guardado na chave
+static inline int dna_length(const dna_key* key) {
+    int len = (int)(key->w[1] & 0xFF);
+    return len > DNA_KEY_MAX_BASES ? DNA_KEY_MAX_BASES : len;
+}
+
+// desempacota a chave para texto (seq precisa de DNA_KEY_MAX_BASES + 1)
+void dna_unpack(const dna_key* key, char* seq) {
+    int len = dna_length(key);
+    for (int i = 0; i < len; i++) {
+        seq[i] = DNA_CHARS[(key->w[i / 32] >> (62 - 2 * (i % 32))) & 3];
+    }
+    seq[len] = '\0';
+}
+
+static inline int dna_key_cmp(const dna_key* a, const dna_key* b) {
+    if (a->w[0] != b->w[0]) return a->w[0] < b->w[0] ? -1 : 1;
+    if (a->w[1] != b->w[1]) return a->w[1] < b->w[1] ? -1 : 1;
+    return 0;
+}
+
 int compare_dna(const void* a, const void* b) {
-    return strcmp((char*)a, (char*)b);
+    return dna_key_cmp((const dna_key*)a, (const dna_key*)b);
 }
 
-// Função para mesclar dois arrays ordenados
-void merge_sorted_arrays(char** arr1, int size1, char** arr2, int size2, char** result) {
-    int i = 0, j = 0, k = 0;
-    
-    while (i < size1 && j < size2) {
-        if (strcmp(arr1[i], arr2[j]) <= 0) {
-            strcpy(result[k++], arr1[i++]);
-        } else {
-            strcpy(result[k++], arr2[j++]);
+// Verificação distribuída, sem juntar os dados num processo
+// Resumo de multiconjunto: soma (mod 2^64) de dois hashes de cada chave.
+// A soma não depende da ordem nem de onde a chave está, então o resumo da
+// saída só bate com o da entrada se ela for uma permutação da entrada
+typedef struct {
+    uint64_t h[2];
+    uint64_t count;
+} multiset_digest;
+
+// finalizador do splitmix64
+static inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+void digest_keys(const dna_key* keys, int n, multiset_digest* d) {
+    d->h[0] = d->h[1] = 0;
+    d->count = n;
+    for (int i = 0; i < n; i++) {
+        d->h[0] += mix64(keys[i].w[0] ^ mix64(keys[i].w[1] + 0x9e3779b97f4a7c15ULL));
+        d->h[1] += mix64(keys[i].w[1] ^ mix64(keys[i].w[0] + 0x632be59bd9b4e019ULL));
+    }
+}
+
+// Coletiva. Cada rank confere a própria ordem; as pontas (primeira e última
+// chave) de todos os ranks vêm num Allgather de p registros, e cada um
+// compara a sua primeira com a última do rank não vazio anterior. Os
+// resumos de entrada e saída são somados num único Allreduce
+void verify_sorted(const dna_key* keys, int n, const multiset_digest* input, int* ordered,
+                   int* permutation, MPI_Comm comm) {
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    int ok = 1;
+    for (int i = 0; i + 1 < n && ok; i++) {
+        if (dna_key_cmp(&keys[i], &keys[i + 1]) > 0) {
+            fprintf(stderr, "Processo %d: fora de ordem nas posicoes locais %d-%d\n", rank, i,
+                    i + 1);
+            ok = 0;
         }
     }
-    
-    while (i < size1) {
-        strcpy(result[k++], arr1[i++]);
+
+    dna_key ends[2];
+    memset(ends, 0, sizeof(ends));
+    if (n > 0) {
+        ends[0] = keys[0];
+        ends[1] = keys[n - 1];
     }
-    
-    while (j < size2) {
-        strcpy(result[k++], arr2[j++]);
+    dna_key* all_ends = malloc(2 * size * sizeof(dna_key));
+    int* all_counts = malloc(size * sizeof(int));
+    MPI_Allgather(ends, 2 * sizeof(dna_key), MPI_BYTE, all_ends, 2 * sizeof(dna_key), MPI_BYTE,
+                  comm);
+    MPI_Allgather(&n, 1, MPI_INT, all_counts, 1, MPI_INT, comm);
+    int previous = rank - 1;
+    while (previous >= 0 && all_counts[previous] == 0) previous--;
+    if (n > 0 && previous >= 0 && dna_key_cmp(&all_ends[2 * previous + 1], &keys[0]) > 0) {
+        fprintf(stderr, "Processo %d: primeira chave menor que a ultima do processo %d\n", rank,
+                previous);
+        ok = 0;
+    }
+    free(all_ends);
+    free(all_counts);
+    MPI_Allreduce(&ok, ordered, 1, MPI_INT, MPI_LAND, comm);
+
+    multiset_digest output;
+    digest_keys(keys, n, &output);
+    uint64_t local_sums[6] = {input->h[0], input->h[1], input->count,
+                              output.h[0], output.h[1], output.count};
+    uint64_t sums[6];
+    MPI_Allreduce(local_sums, sums, 6, MPI_UINT64_T, MPI_SUM, comm);
+    *permutation = sums[0] == sums[3] && sums[1] == sums[4] && sums[2] == sums[5];
+}
+
+void arena_init(dna_arena* arena, int capacity) {
+    size_t bytes = (size_t)(capacity > 0 ? capacity : 1) * sizeof(dna_key);
+    bytes = (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    arena->keys = (dna_key*)aligned_alloc(ARENA_ALIGNMENT, bytes);
+    arena->count = 0;
+    arena->capacity = capacity;
+    if (arena->keys == NULL) {
+        fprintf(stderr, "Erro ao alocar arena de %d registros\n", capacity);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+}
+
+void arena_free(dna_arena* arena) {
+    free(arena->keys);
+    arena->keys = NULL;
+    arena->count = arena->capacity = 0;
+}
+
+// troca o conteudo de duas arenas (a metade mantida vira o bloco local)
+void arena_swap(dna_arena* a, dna_arena* b) {
+    dna_arena tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Escrita paralela com MPI-IO: cada rank decodifica o seu bloco ordenado,
+// acha o seu deslocamento no arquivo com a soma de prefixo exclusiva dos
+// tamanhos em bytes (MPI_Exscan) e escreve na posição certa com uma escrita
+// coletiva. Os blocos estão em ordem de rank, então o arquivo sai ordenado
+void write_dna_file_mpiio(const char* filename, const dna_key* keys, int count, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    long long bytes = 0;
+    for (int i = 0; i < count; i++) {
+        bytes += dna_length(&keys[i]) + 1;
+    }
+    char* text = (char*)malloc(bytes + 1);
+    if (text == NULL) {
+        fprintf(stderr, "Processo %d: erro ao alocar %lld bytes de saida\n", rank, bytes);
+        MPI_Abort(comm, 1);
+    }
+    char* p = text;
+    for (int i = 0; i < count; i++) {
+        int len = dna_length(&keys[i]);
+        dna_unpack(&keys[i], p);
+        p[len] = '\n';
+        p += len + 1;
+    }
+
+    long long offset = 0, total = 0;
+    MPI_Exscan(&bytes, &offset, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) offset = 0;  // Exscan não define o valor no rank 0
+    MPI_Allreduce(&bytes, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+    MPI_File fh;
+    if (MPI_File_open(comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                      &fh) != MPI_SUCCESS) {
+        if (rank == 0) fprintf(stderr, "Erro ao criar arquivo %s\n", filename);
+        MPI_Abort(comm, 1);
+    }
+    // descarta o conteúdo de execuções anteriores mais longas
+    MPI_File_set_size(fh, total);
+
+    long long rounds = (bytes + MPIIO_CHUNK - 1) / MPIIO_CHUNK;
+    long long max_rounds;
+    MPI_Allreduce(&rounds, &max_rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    long long done = 0;
+    for (long long r = 0; r < max_rounds; r++) {
+        int chunk = bytes - done < MPIIO_CHUNK ? (int)(bytes - done) : MPIIO_CHUNK;
+        MPI_File_write_at_all(fh, offset + done, text + done, chunk, MPI_BYTE,
+                              MPI_STATUS_IGNORE);
+        done += chunk;
+    }
+    MPI_File_close(&fh);
+    free(text);
+}
+
+// Escrita paralela do formato binário: deslocamento pela soma de prefixo das
+// contagens e os blocos gravados como estão, sem decodificar; o processo 0
+// grava o cabeçalho
+void write_dna_binary_mpiio(const char* filename, const dna_key* keys, int count,
+                            int seq_length, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    long long n = count, first = 0, total = 0;
+    MPI_Exscan(&n, &first, 1, MPI_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0) first = 0;  // Exscan não define o valor no rank 0
+    MPI_Allreduce(&n, &total, 1, MPI_LONG_LONG, MPI_SUM, comm);
+
+    MPI_File fh;
+    if (MPI_File_open(comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                      &fh) != MPI_SUCCESS) {
+        if (rank == 0) fprintf(stderr, "Erro ao criar arquivo %s\n", filename);
+        MPI_Abort(comm, 1);
+    }
+    MPI_Offset header = sizeof(dna_bin_header);
+    MPI_File_set_size(fh, header + total * (MPI_Offset)sizeof(dna_key));
+    if (rank == 0) {
+        dna_bin_header h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, DNA_BIN_MAGIC, sizeof(DNA_BIN_MAGIC));
+        h.version = DNA_BIN_VERSION;
+        h.encoding = DNA_BIN_ENCODING_2BIT;
+        h.count = total;
+        h.seq_length = seq_length;
+        h.record_size = sizeof(dna_key);
+        MPI_File_write_at(fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+
+    long long bytes = n * (long long)sizeof(dna_key);
+    long long rounds = (bytes + MPIIO_CHUNK - 1) / MPIIO_CHUNK;
+    long long max_rounds;
+    MPI_Allreduce(&rounds, &max_rounds, 1, MPI_LONG_LONG, MPI_MAX, comm);
+    const char* data = (const char*)keys;
+    long long done = 0;
+    for (long long r = 0; r < max_rounds; r++) {
+        int chunk = bytes - done < MPIIO_CHUNK ? (int)(bytes - done) : MPIIO_CHUNK;
+        MPI_File_write_at_all(fh, header + first * (MPI_Offset)sizeof(dna_key) + done,
+                              data + done, chunk, MPI_BYTE, MPI_STATUS_IGNORE);
+        done += chunk;
+    }
+    MPI_File_close(&fh);
+}
+
+// Merge parcial: gera só os k menores de a e b, da frente para trás
+void merge_smallest(const dna_key* a, int size_a, const dna_key* b, int size_b,
+                    dna_key* result, int k) {
+    int i = 0, j = 0;
+    for (int m = 0; m < k; m++) {
+        if (j >= size_b || (i < size_a && dna_key_cmp(&a[i], &b[j]) <= 0)) {
+            result[m] = a[i++];
+        } else {
+            result[m] = b[j++];
+        }
+    }
+}
+
+// Merge parcial: gera só os k maiores de a e b, de trás para a frente
+void merge_largest(const dna_key* a, int size_a, const dna_key* b, int size_b,
+                   dna_key* result, int k) {
+    int i = size_a - 1, j = size_b - 1;
+    for (int m = k - 1; m >= 0; m--) {
+        if (j < 0 || (i >= 0 && dna_key_cmp(&a[i], &b[j]) > 0)) {
+            result[m] = a[i--];
+        } else {
+            result[m] = b[j--];
+        }
     }
 }
 
 // Operação compare-separa (em vez de compare-troca)
-void compare_separate(int partner, char** local_data, int local_size, 
-                     char** partner_data, int partner_size, int seq_length, 
-                     int keep_smaller, int my_rank) {
-    
-    // Envia tamanho primeiro
-    MPI_Send(&local_size, 1, MPI_INT, partner, 0, MPI_COMM_WORLD);
+// Só a metade mantida é mesclada, direto no buffer persistente, que depois
+// troca de lugar com o bloco local; nada é alocado por fase
+// Retorna 1 se os blocos foram trocados e 0 se já estavam em ordem
+int compare_separate(int partner, dna_arena* local, split_workspace* ws, int keep_smaller) {
+    int local_size = local->count;
     
-    // Envia todos os dados locais
-    for (int i = 0; i < local_size; i++) {
-        MPI_Send(local_data[i], seq_length + 1, MPI_CHAR, partner, 1, MPI_COMM_WORLD);
+    // Troca primeiro só os tamanhos e os extremos dos blocos
+    block_edge mine, theirs;
+    memset(&mine, 0, sizeof(mine));
+    mine.size = local_size;
+    if (local_size > 0) {
+        mine.key = keep_smaller ? local->keys[local_size - 1] : local->keys[0];
     }
+    int t = trace_begin("bordas");
+    MPI_Sendrecv(&mine, sizeof(block_edge), MPI_BYTE, partner, 0,
+                 &theirs, sizeof(block_edge), MPI_BYTE, partner, 0,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    trace_end(t, sizeof(block_edge), sizeof(block_edge));
+    int partner_size = theirs.size;
     
-    // Recebe tamanho do parceiro
-    MPI_Recv(&partner_size, 1, MPI_INT, partner, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    // Se o maior do bloco de baixo não passa do menor do bloco de cima,
+    // nada mudaria: os dois lados chegam à mesma conclusão e não trocam dados
+    if (local_size == 0 || partner_size == 0) return 0;
+    const dna_key* low_max = keep_smaller ? &mine.key : &theirs.key;
+    const dna_key* high_min = keep_smaller ? &theirs.key : &mine.key;
+    if (dna_key_cmp(low_max, high_min) <= 0) return 0;
     
-    // Aloca memória para dados do parceiro
-    partner_data = (char**)malloc(partner_size * sizeof(char*));
-    for (int i = 0; i < partner_size; i++) {
-        partner_data[i] = (char*)malloc((seq_length + 1) * sizeof(char));
-        MPI_Recv(partner_data[i], seq_length + 1, MPI_CHAR, partner, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    if (partner_size > ws->partner.capacity || local_size > ws->kept.capacity) {
+        fprintf(stderr, "Bloco maior que o buffer do compare-separa\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
     
-    // Mescla os dois arrays
-    char** merged = (char**)malloc((local_size + partner_size) * sizeof(char*));
-    for (int i = 0; i < local_size + partner_size; i++) {
-        merged[i] = (char*)malloc((seq_length + 1) * sizeof(char));
-    }
+    // Troca os blocos inteiros em uma única mensagem; o Sendrecv não
+    // depende do buffer eager, então não trava
+    t = trace_begin("troca_blocos");
+    MPI_Sendrecv(local->keys, local_size * sizeof(dna_key), MPI_BYTE, partner, 1,
+                 ws->partner.keys, partner_size * sizeof(dna_key), MPI_BYTE, partner, 1,
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    trace_end(t, (long long)local_size * sizeof(dna_key),
+              (long long)partner_size * sizeof(dna_key));
+    ws->partner.count = partner_size;
     
-    merge_sorted_arrays(local_data, local_size, partner_data, partner_size, merged);
-    
-    // Decide quais elementos manter
+    t = trace_begin("intercalacao");
     if (keep_smaller) {
-        // Mantém os menores
-        for (int i = 0; i < local_size; i++) {
-            strcpy(local_data[i], merged[i]);
-        }
+        merge_smallest(local->keys, local_size, ws->partner.keys, partner_size,
+                       ws->kept.keys, local_size);
     } else {
-        // Mantém os maiores
-        for (int i = 0; i < local_size; i++) {
-            strcpy(local_data[i], merged[partner_size + i]);
-        }
-    }
-    
-    // Libera memória
-    for (int i = 0; i < local_size + partner_size; i++) {
-        free(merged[i]);
-    }
-    free(merged);
-    
-    for (int i = 0; i < partner_size; i++) {
-        free(partner_data[i]);
+        merge_largest(local->keys, local_size, ws->partner.keys, partner_size,
+                      ws->kept.keys, local_size);
     }
-    free(partner_data);
+    ws->kept.count = local_size;
+    arena_swap(local, &ws->kept);
+    trace_end(t, 0, 0);
+    return 1;
 }
 
 // Algoritmo Odd-Even Sort paralelo com blocos
-void odd_even_parallel_sort_blocks(char** local_data, int local_size, int seq_length, 
-                                  int n, int my_rank, int num_procs) {
+// Com early_stop, cada fase termina com um Allreduce que diz se algum par
+// trocou dados (no lugar da barreira); uma fase ímpar e uma par seguidas sem
+// trocas cobrem todos os pares vizinhos, então a ordenação já terminou
+// Retorna o número de fases executadas
+int odd_even_parallel_sort_blocks(dna_arena* local, int n, int my_rank, int num_procs,
+                                  int early_stop) {
     
     // Primeiro passo: ordenação local
-    qsort(local_data, local_size, sizeof(char*), compare_dna);
+    int t = trace_begin("ordenacao_local");
+    qsort(local->keys, local->count, sizeof(dna_key), compare_dna);
+    trace_end(t, 0, 0);
+    
+    // Nenhum bloco passa de ceil(n / p) registros
+    int max_block = n / num_procs + (n % num_procs != 0);
+    split_workspace ws;
+    arena_init(&ws.partner, max_block);
+    arena_init(&ws.kept, local->count);
     
+    int quiet_phases = 0;
+    int phases = num_procs;
     for (int i = 1; i <= num_procs; i++) {
+        char phase_name[TRACE_NAME_LENGTH];
+        snprintf(phase_name, sizeof(phase_name), "fase %d", i);
+        int phase = trace_begin(phase_name);
+        int moved = 0;
         if (i % 2 == 1) { // Iteração ímpar
             if (my_rank % 2 == 1) { // Processo ímpar
                 if (my_rank < num_procs - 1) {
-                    int partner_size;
-                    char** partner_data;
-                    compare_separate(my_rank + 1, local_data, local_size, 
-                                   partner_data, partner_size, seq_length, 
-                                   1, my_rank); // Mantém os menores
+                    moved = compare_separate(my_rank + 1, local, &ws, 1); // Mantém os menores
                 }
             } else { // Processo par
                 if (my_rank > 0) {
-                    int partner_size;
-                    char** partner_data;
-                    compare_separate(my_rank - 1, local_data, local_size, 
-                                   partner_data, partner_size, seq_length, 
-                                   0, my_rank); // Mantém os maiores
+                    moved = compare_separate(my_rank - 1, local, &ws, 0); // Mantém os maiores
                 }
             }
         } else { // Iteração par
             if (my_rank % 2 == 0) { // Processo par
                 if (my_rank < num_procs - 1) {
-                    int partner_size;
-                    char** partner_data;
-                    compare_separate(my_rank + 1, local_data, local_size, 
-                                   partner_data, partner_size, seq_length, 
-                                   1, my_rank); // Mantém os menores
+                    moved = compare_separate(my_rank + 1, local, &ws, 1); // Mantém os menores
                 }
             } else { // Processo ímpar
                 if (my_rank > 0) {
-                    int partner_size;
-                    char** partner_data;
-                    compare_separate(my_rank - 1, local_data, local_size, 
-                                   partner_data, partner_size, seq_length, 
-                                   0, my_rank); // Mantém os maiores
+                    moved = compare_separate(my_rank - 1, local, &ws, 0); // Mantém os maiores
                 }
             }
         }
         
-        MPI_Barrier(MPI_COMM_WORLD);
+        // espera pelos outros pares: o tempo aqui é desbalanceamento
+        if (early_stop) {
+            int any_moved;
+            t = trace_begin("allreduce");
+            MPI_Allreduce(&moved, &any_moved, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+            trace_end(t, sizeof(int), sizeof(int));
+            trace_end(phase, 0, 0);
+            quiet_phases = any_moved ? 0 : quiet_phases + 1;
+            if (quiet_phases == 2) {
+                phases = i;
+                break;
+            }
+        } else {
+            t = trace_begin("barreira");
+            MPI_Barrier(MPI_COMM_WORLD);
+            trace_end(t, 0, 0);
+            trace_end(phase, 0, 0);
+        }
     }
+    
+    arena_free(&ws.partner);
+    arena_free(&ws.kept);
+    return phases;
 }
 
 int main(int argc, char** argv) {
@@ -153,16 +606,61 @@ int main(int argc, char** argv) {
     MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
     MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
     
-    if (argc != 3) {
+    // -e: para assim que uma fase ímpar e uma par não trocarem nada
+    // -q: não lista as sequências (medições com n grande)
+    // -T arquivo: linha do tempo por rank em JSON de eventos do Chrome
+    // -f texto|binario: formato do arquivo de saída
+    // -d aleatoria|ordenada|quase: entrada gerada; quase é a ordenada com cada
+    // sequência deslocada até meio bloco, então só cruza para o rank vizinho
+    int early_stop = 0;
+    int input_order = INPUT_RANDOM;
+    int quiet = 0;
+    int binary = 0;
+    const char* trace_file = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "eqT:f:d:")) != -1) {
+        if (opt == 'e') {
+            early_stop = 1;
+        } else if (opt == 'q') {
+            quiet = 1;
+        } else if (opt == 'T') {
+            trace_file = optarg;
+        } else if (opt == 'f' && strcmp(optarg, "texto") == 0) {
+            binary = 0;
+        } else if (opt == 'f' && strcmp(optarg, "binario") == 0) {
+            binary = 1;
+        } else if (opt == 'd' && strcmp(optarg, "aleatoria") == 0) {
+            input_order = INPUT_RANDOM;
+        } else if (opt == 'd' && strcmp(optarg, "ordenada") == 0) {
+            input_order = INPUT_SORTED;
+        } else if (opt == 'd' && strcmp(optarg, "quase") == 0) {
+            input_order = INPUT_NEARLY_SORTED;
+        } else {
+            early_stop = -1;
+        }
+    }
+    int positional = argc - optind;
+    
+    if (early_stop < 0 || (positional != 2 && positional != 3)) {
         if (my_rank == 0) {
-            printf("Uso: %s <numero_total_de_sequencias> <comprimento_das_sequencias>\n", argv[0]);
+            printf("Uso: %s [-e] [-q] [-T linha_do_tempo.json] [-f texto|binario] [-d aleatoria|ordenada|quase] <numero_total_de_sequencias> <comprimento_das_sequencias> [arquivo_saida]\n", argv[0]);
         }
         MPI_Finalize();
         return 1;
     }
     
-    n = atoi(argv[1]);
-    seq_length = atoi(argv[2]);
+    n = atoi(argv[optind]);
+    seq_length = atoi(argv[optind + 1]);
+    // se informado, cada processo escreve o seu bloco ordenado direto no arquivo
+    const char* output_file = positional == 3 ? argv[optind + 2] : NULL;
+    
+    if (seq_length < 1 || seq_length > DNA_KEY_MAX_BASES) {
+        if (my_rank == 0) {
+            printf("Comprimento deve estar entre 1 e %d\n", DNA_KEY_MAX_BASES);
+        }
+        MPI_Finalize();
+        return 1;
+    }
     
     // Calcula o número de elementos por processo
     int local_n = n / num_procs;
@@ -176,11 +674,42 @@ int main(int argc, char** argv) {
     // Semente aleatória consistente
     srand(42 + my_rank);
     
-    // Cada processo gera suas próprias sequências
-    char** local_sequences = (char**)malloc(local_n * sizeof(char*));
+    // posição global do primeiro elemento deste processo e deslocamento
+    // máximo da entrada quase ordenada
+    long long first = (long long)my_rank * (n / num_procs) +
+                      (my_rank < remainder ? my_rank : remainder);
+    int jitter = n / num_procs / 2;
+    
+    // Cada processo gera suas próprias sequências, já empacotadas na arena
+    dna_arena local;
+    arena_init(&local, local_n);
+    char seq_buffer[DNA_KEY_MAX_BASES + 1];
     for (int i = 0; i < local_n; i++) {
-        local_sequences[i] = (char*)malloc((seq_length + 1) * sizeof(char));
-        generate_dna_sequence(local_sequences[i], seq_length);
+        if (input_order == INPUT_RANDOM) {
+            generate_dna_sequence(seq_buffer, seq_length);
+        } else {
+            long long v = first + i;
+            if (input_order == INPUT_NEARLY_SORTED && jitter > 0) {
+                v += rand() % (2 * jitter + 1) - jitter;
+                if (v < 0) v = 0;
+            }
+            generate_ordered_sequence(seq_buffer, seq_length, v);
+        }
+        dna_pack(seq_buffer, &local.keys[i]);
+    }
+    local.count = local_n;
+    dna_key* local_sequences = local.keys;
+    
+    // resumo da entrada, para a verificação no fim
+    multiset_digest input_digest;
+    digest_keys(local.keys, local_n, &input_digest);
+    
+    // Arena do processo 0 para as coletas (reusada na inicial e na final);
+    // com -q nada é coletado
+    dna_arena all_sequences = {NULL, 0, 0};
+    if (my_rank == 0 && !quiet) {
+        arena_init(&all_sequences, n);
+        all_sequences.count = n;
     }
     
     // Processo 0 coleta e exibe TODAS as sequências iniciais
@@ -190,53 +719,62 @@ int main(int argc, char** argv) {
         printf("Numero de processos: %d\n", num_procs);
         printf("Comprimento das sequencias: %d\n", seq_length);
         printf("Elementos por processo: ~%d\n", n / num_procs);
-        
+        printf("Entrada: %s\n", input_order == INPUT_SORTED ? "ordenada" :
+               input_order == INPUT_NEARLY_SORTED ? "quase ordenada" : "aleatoria");
+    }
+    
+    // Processo 0 coleta e exibe a distribuição inicial
+    if (my_rank == 0 && !quiet) {
         // Coleta informações sobre distribuição
         int* counts = (int*)malloc(num_procs * sizeof(int));
         int* displacements = (int*)malloc(num_procs * sizeof(int));
         
-        counts[0] = local_n;
+        // Contagens e deslocamentos em bytes de chaves
+        counts[0] = local_n * sizeof(dna_key);
         displacements[0] = 0;
         
         for (int i = 1; i < num_procs; i++) {
             int other_n = n / num_procs;
             if (i < remainder) other_n++;
-            counts[i] = other_n;
+            counts[i] = other_n * sizeof(dna_key);
             displacements[i] = displacements[i-1] + counts[i-1];
         }
         
-        // Aloca memória para todas as sequências iniciais
-        char* all_initial_sequences = (char*)malloc(n * (seq_length + 1) * sizeof(char));
+        dna_key* all_initial_sequences = all_sequences.keys;
         
         // Coleta todas as sequências
-        MPI_Gatherv(local_sequences[0], local_n * (seq_length + 1), MPI_CHAR,
-                   all_initial_sequences, counts, displacements, MPI_CHAR, 0, MPI_COMM_WORLD);
+        MPI_Gatherv(local_sequences, local_n * sizeof(dna_key), MPI_BYTE,
+                   all_initial_sequences, counts, displacements, MPI_BYTE, 0, MPI_COMM_WORLD);
         
         printf("\n=== DISTRIBUICAO INICIAL ===\n");
         int offset = 0;
         for (int i = 0; i < num_procs; i++) {
-            printf("\nProcesso %d (%d elementos):\n", i, counts[i]);
-            for (int j = 0; j < counts[i]; j++) {
-                char* seq_ptr = all_initial_sequences + (offset + j) * (seq_length + 1);
-                printf("  [%d] %s\n", j, seq_ptr);
+            int count = counts[i] / sizeof(dna_key);
+            printf("\nProcesso %d (%d elementos):\n", i, count);
+            for (int j = 0; j < count; j++) {
+                dna_unpack(&all_initial_sequences[offset + j], seq_buffer);
+                printf("  [%d] %s\n", j, seq_buffer);
             }
-            offset += counts[i];
+            offset += count;
         }
         
         free(counts);
         free(displacements);
-        free(all_initial_sequences);
-    } else {
+    } else if (!quiet) {
         // Outros processos enviam suas sequências
-        MPI_Gatherv(local_sequences[0], local_n * (seq_length + 1), MPI_CHAR,
-                   NULL, 0, NULL, MPI_CHAR, 0, MPI_COMM_WORLD);
+        MPI_Gatherv(local_sequences, local_n * sizeof(dna_key), MPI_BYTE,
+                   NULL, 0, NULL, MPI_BYTE, 0, MPI_COMM_WORLD);
     }
     
+    if (trace_file) trace_enable(MPI_COMM_WORLD);
+
     // Mede o tempo da ordenação paralela
     MPI_Barrier(MPI_COMM_WORLD);
     start_time = MPI_Wtime();
     
-    odd_even_parallel_sort_blocks(local_sequences, local_n, seq_length, n, my_rank, num_procs);
+    int phases = odd_even_parallel_sort_blocks(&local, n, my_rank, num_procs, early_stop);
+    // o bloco local pode ter trocado de buffer durante as fases
+    local_sequences = local.keys;
     
     end_time = MPI_Wtime();
     double parallel_time = end_time - start_time;
@@ -245,8 +783,37 @@ int main(int argc, char** argv) {
     double max_time;
     MPI_Reduce(&parallel_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
     
-    // Processo 0 coleta e exibe os resultados finais
+    if (output_file) {
+        int t = trace_begin("escrita");
+        if (binary) {
+            write_dna_binary_mpiio(output_file, local_sequences, local_n, seq_length,
+                                   MPI_COMM_WORLD);
+        } else {
+            write_dna_file_mpiio(output_file, local_sequences, local_n, MPI_COMM_WORLD);
+        }
+        trace_end(t, 0, 0);
+        if (my_rank == 0) {
+            printf("\nSequencias ordenadas escritas em %s\n", output_file);
+        }
+    }
+    
+    // Verificação distribuída: ordem local, pontas entre ranks e resumo de
+    // multiconjunto da entrada contra o da saída
+    int ordered, permutation;
+    int t = trace_begin("verificacao");
+    verify_sorted(local_sequences, local_n, &input_digest, &ordered, &permutation,
+                  MPI_COMM_WORLD);
+    trace_end(t, 0, 0);
+    
     if (my_rank == 0) {
+        printf("\n=== RESULTADO FINAL ===\n");
+        printf("Tempo de execucao: %.6f segundos\n", max_time);
+        printf("Tempo de execucao: %.3f milissegundos\n", max_time * 1000);
+        printf("Fases executadas: %d de %d\n", phases, num_procs);
+    }
+    
+    // Processo 0 coleta e exibe os resultados finais
+    if (my_rank == 0 && !quiet) {
         // Prepara para Gatherv
         int* counts = (int*)malloc(num_procs * sizeof(int));
         int* displacements = (int*)malloc(num_procs * sizeof(int));
@@ -255,63 +822,59 @@ int main(int argc, char** argv) {
         int my_count = local_n;
         MPI_Gather(&my_count, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
         
+        // Converte as contagens para bytes de chaves
+        for (int i = 0; i < num_procs; i++) {
+            counts[i] *= sizeof(dna_key);
+        }
         displacements[0] = 0;
         for (int i = 1; i < num_procs; i++) {
             displacements[i] = displacements[i-1] + counts[i-1];
         }
         
-        // Aloca memória para todas as sequências finais
-        char* all_final_sequences = (char*)malloc(n * (seq_length + 1) * sizeof(char));
+        dna_key* all_final_sequences = all_sequences.keys;
         
         // Coleta todas as sequências ordenadas
-        MPI_Gatherv(local_sequences[0], local_n * (seq_length + 1), MPI_CHAR,
-                   all_final_sequences, counts, displacements, MPI_CHAR, 0, MPI_COMM_WORLD);
-        
-        printf("\n=== RESULTADO FINAL ===\n");
-        printf("Tempo de execucao: %.6f segundos\n", max_time);
-        printf("Tempo de execucao: %.3f milissegundos\n", max_time * 1000);
+        MPI_Gatherv(local_sequences, local_n * sizeof(dna_key), MPI_BYTE,
+                   all_final_sequences, counts, displacements, MPI_BYTE, 0, MPI_COMM_WORLD);
         
         printf("\nSequencias ordenadas por processo:\n");
         int offset = 0;
         for (int i = 0; i < num_procs; i++) {
-            printf("\nProcesso %d (%d elementos):\n", i, counts[i]);
-            for (int j = 0; j < counts[i]; j++) {
-                char* seq_ptr = all_final_sequences + (offset + j) * (seq_length + 1);
-                printf("  [%d] %s\n", j, seq_ptr);
+            int count = counts[i] / sizeof(dna_key);
+            printf("\nProcesso %d (%d elementos):\n", i, count);
+            for (int j = 0; j < count; j++) {
+                dna_unpack(&all_final_sequences[offset + j], seq_buffer);
+                printf("  [%d] %s\n", j, seq_buffer);
             }
-            offset += counts[i];
+            offset += count;
         }
         
-        // Verifica ordenação global
-        printf("\nVerificacao de ordenacao global:\n");
-        int sorted = 1;
-        for (int i = 0; i < n - 1; i++) {
-            char* seq1 = all_final_sequences + i * (seq_length + 1);
-            char* seq2 = all_final_sequences + (i + 1) * (seq_length + 1);
-            if (strcmp(seq1, seq2) > 0) {
-                sorted = 0;
-                printf("ERRO: %s > %s (posicoes %d-%d)\n", seq1, seq2, i, i+1);
-                break;
-            }
-        }
-        printf("Ordenacao global: %s\n", sorted ? "CORRETO" : "INCORRETO");
-        
         free(counts);
         free(displacements);
-        free(all_final_sequences);
         
-    } else {
+    } else if (!quiet) {
         // Outros processos enviam tamanho e dados
         MPI_Gather(&local_n, 1, MPI_INT, NULL, 0, MPI_INT, 0, MPI_COMM_WORLD);
-        MPI_Gatherv(local_sequences[0], local_n * (seq_length + 1), MPI_CHAR,
-                   NULL, 0, NULL, MPI_CHAR, 0, MPI_COMM_WORLD);
+        MPI_Gatherv(local_sequences, local_n * sizeof(dna_key), MPI_BYTE,
+                   NULL, 0, NULL, MPI_BYTE, 0, MPI_COMM_WORLD);
     }
     
-    // Libera memória
-    for (int i = 0; i < local_n; i++) {
-        free(local_sequences[i]);
+    if (my_rank == 0) {
+        printf("\nVerificacao de ordenacao global:\n");
+        printf("Ordem entre e dentro dos processos: %s\n", ordered ? "CORRETO" : "INCORRETO");
+        printf("Permutacao da entrada (resumo de multiconjunto): %s\n",
+               permutation ? "CORRETO" : "INCORRETO");
+        printf("Ordenacao global: %s\n", ordered && permutation ? "CORRETO" : "INCORRETO");
+    }
+    
+    if (trace_file) {
+        trace_write(trace_file, MPI_COMM_WORLD);
+        if (my_rank == 0) printf("Linha do tempo em %s\n", trace_file);
     }
-    free(local_sequences);
+    
+    // Libera memória
+    arena_free(&local);
+    arena_free(&all_sequences);
     
     MPI_Finalize();
     return 0;